@@ -34,83 +34,576 @@
   */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+
 #include "button.h"
 #include "esp_log.h"
 
+#ifdef CONFIG_BUTTON_GROUP
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#endif /* CONFIG_BUTTON_GROUP */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+#include "freertos/semphr.h"
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#if defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)
+#include "esp_intr_alloc.h"
+#if CONFIG_BUTTON_ISR_CORE_ID >= 0
+#include "esp_ipc.h"
+#endif /* CONFIG_BUTTON_ISR_CORE_ID >= 0 */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE */
+
+#if defined(CONFIG_BUTTON_ENGINE_SCAN) || defined(CONFIG_BUTTON_TIME_SOURCE_ESP_TIMER)
+#include "esp_timer.h"
+#endif /* CONFIG_BUTTON_ENGINE_SCAN || CONFIG_BUTTON_TIME_SOURCE_ESP_TIMER */
+
+#ifdef CONFIG_BUTTON_WAKEUP
+#include "esp_sleep.h"
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+#include "esp_pm.h"
+#endif /* CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+#include "driver/rtc_io.h"
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+
 /* External variables --------------------------------------------------------*/
 
 /* Private typedef -----------------------------------------------------------*/
+#ifdef CONFIG_BUTTON_COMBO
+/* Chord or sequence of buttons of the button service */
+typedef struct {
+	uint64_t mask;														/*!< Combination buttons, bit per button id */
+	uint8_t ids[CONFIG_BUTTON_COMBO_MAX_LENGTH];	/*!< Sequence buttons in press order */
+	uint8_t num;															/*!< Number of buttons */
+	bool sequence;														/*!< Sequence instead of chord */
+	bool suppress;														/*!< Drop the clicks of the buttons when it fires */
+	bool fired;																/*!< Chord fired for the current hold */
+	uint8_t step;															/*!< Sequence buttons pressed so far */
+	button_time_t time;												/*!< Chord hold time or sequence step window */
+	button_time_t start;											/*!< Chord complete or last sequence press time, -1 if none */
+	button_function_t function;								/*!< Combination callback */
+} button_combo_t;
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+/* Function run by the timer task between two timer callbacks */
+typedef struct {
+	void (*function)(void *arg);							/*!< Function, NULL to only wait */
+	void *arg;																/*!< Function argument */
+	SemaphoreHandle_t done;										/*!< Given once the function returns */
+} button_timer_call_t;
+
+/* Config applied by the timer task */
+typedef struct {
+	button_t *button;													/*!< Button to configure */
+	const button_config_t *config;						/*!< New config */
+	esp_err_t ret;														/*!< Result of the config check */
+} button_config_arg_t;
+
+/* Gestures applied by the timer task */
+typedef struct {
+	button_t *button;													/*!< Button to configure */
+	uint8_t max_clicks;												/*!< Clicks reported without waiting for the window */
+	button_core_time_t repeat_delay;					/*!< Hold time of the first repeat in microseconds */
+	button_core_time_t repeat_period;					/*!< Time between repeats in microseconds */
+} button_gestures_arg_t;
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
 
 /* Private macro -------------------------------------------------------------*/
-/* Button event bits */
-#define BUTTON_SHORT_PRESS_BIT				BIT0
-#define BUTTON_MEDIUM_PRESS_BIT				BIT1
-#define BUTTON_LONG_PRESS_BIT					BIT2
-#define BUTTON_DOUBLE_CLICK_PRESS_BIT	BIT3
+#ifdef CONFIG_BUTTON_COMBO
+/* Button state events posted to the button service for the combinations */
+#define BUTTON_EVENT_PRESS		(BUTTON_CLICK_MAX)
+#define BUTTON_EVENT_RELEASE	(BUTTON_CLICK_MAX + 1)
+
+/* Buttons that can be part of a combination */
+#define BUTTON_COMBO_IDS			64
+#endif /* CONFIG_BUTTON_COMBO */
+
+/* Event ring sizes must be a power of two */
+#define IS_POWER_OF_TWO(x)	((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+#ifdef CONFIG_BUTTON_COMBO
+_Static_assert(IS_POWER_OF_TWO(CONFIG_BUTTON_COMBO_QUEUE_SIZE),
+		"CONFIG_BUTTON_COMBO_QUEUE_SIZE must be a power of two");
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+/* The work of the running callback is kept in a thread local storage pointer */
+_Static_assert(CONFIG_BUTTON_TLS_INDEX < configNUM_THREAD_LOCAL_STORAGE_POINTERS,
+		"CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS must exceed CONFIG_BUTTON_TLS_INDEX");
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+_Static_assert(IS_POWER_OF_TWO(CONFIG_BUTTON_TASK_QUEUE_SIZE),
+		"CONFIG_BUTTON_TASK_QUEUE_SIZE must be a power of two");
+/* Events of the same click type are coalesced, one of each must fit */
+_Static_assert(CONFIG_BUTTON_TASK_QUEUE_SIZE >= BUTTON_CLICK_MAX,
+		"CONFIG_BUTTON_TASK_QUEUE_SIZE must hold one event of every click type");
+
+/* Each button has its own ring, the button index is not used */
+#define BUTTON_RING(me)			(&(me)->ring)
+#define BUTTON_ID(me)				0
+#define BUTTON_GENERATION(me)	0
+#else
+_Static_assert(IS_POWER_OF_TWO(CONFIG_BUTTON_SERVICE_QUEUE_SIZE),
+		"CONFIG_BUTTON_SERVICE_QUEUE_SIZE must be a power of two");
+
+/* All the buttons share the service ring */
+#define BUTTON_RING(me)			(&service_ring)
+#define BUTTON_ID(me)				((me)->id)
+#define BUTTON_GENERATION(me)	((me)->generation)
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+
+/* Click types posted after the initialization, the application reads all of
+ * them until it selects some, the callbacks enable their own */
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+#define BUTTON_CLICK_MASK_INIT	((uint8_t)((1 << BUTTON_CLICK_MAX) - 1))
+#else
+#define BUTTON_CLICK_MASK_INIT	0
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+/* Current time in microseconds */
+#ifdef CONFIG_BUTTON_TIME_SOURCE_ESP_TIMER
+#define BUTTON_GET_TIME()					esp_timer_get_time()
+#define BUTTON_GET_TIME_FROM_ISR()	esp_timer_get_time()
+#else
+#define BUTTON_GET_TIME()					((button_time_t)pdTICKS_TO_MS(xTaskGetTickCount()) * 1000)
+#define BUTTON_GET_TIME_FROM_ISR()	((button_time_t)pdTICKS_TO_MS(xTaskGetTickCountFromISR()) * 1000)
+#endif /* CONFIG_BUTTON_TIME_SOURCE_ESP_TIMER */
+
+/* Software timer periods, at least one tick */
+#define BUTTON_TIMER_TICKS(ms)	(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1)
+#define BUTTON_TIMER_TICKS_US(us)	BUTTON_TIMER_TICKS(((us) + 999) / 1000)
+
+/* Software timers expire on a tick, up to one tick before the exact time */
+#define BUTTON_TIMER_SLACK	((button_time_t)portTICK_PERIOD_MS * 1000)
+
+/* Maximum threshold in milliseconds */
+#define BUTTON_TIME_MAX	(BUTTON_CORE_TIME_MAX / 1000)
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+/* Adaptive debounce bounds in microseconds */
+#define BUTTON_DEBOUNCE_MIN_US	((button_core_time_t)CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MIN * 1000)
+#define BUTTON_DEBOUNCE_MAX_US	((button_core_time_t)CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MAX * 1000)
+/* Settles without a longer bounce before the estimate is lowered */
+#define BUTTON_DEBOUNCE_QUIET	8
+
+_Static_assert(CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MIN <= CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MAX,
+		"CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MIN must not exceed CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MAX");
+/* The debounce timer counts ticks, a shorter minimum would round up anyway */
+_Static_assert(CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MIN * configTICK_RATE_HZ >= 1000,
+		"CONFIG_BUTTON_ADAPTIVE_DEBOUNCE_MIN must be at least one tick period");
+
+/* Tick period in microseconds, the ISR converts without 64-bit divisions */
+#define BUTTON_TICK_US	((button_core_time_t)(1000000 / configTICK_RATE_HZ))
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+
+/* Core of the button tasks */
+#if CONFIG_BUTTON_TASK_CORE_ID >= 0
+#define BUTTON_TASK_CORE	CONFIG_BUTTON_TASK_CORE_ID
+#else
+#define BUTTON_TASK_CORE	tskNO_AFFINITY
+#endif /* CONFIG_BUTTON_TASK_CORE_ID >= 0 */
+
+#if defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)
+/* GPIO ISR service allocation flags */
+#ifdef CONFIG_BUTTON_ISR_SHARED
+#define BUTTON_ISR_SHARED_FLAG	ESP_INTR_FLAG_SHARED
+#else
+#define BUTTON_ISR_SHARED_FLAG	0
+#endif /* CONFIG_BUTTON_ISR_SHARED */
+
+#ifdef CONFIG_BUTTON_ISR_IRAM
+#define BUTTON_ISR_IRAM_FLAG		ESP_INTR_FLAG_IRAM
+#else
+#define BUTTON_ISR_IRAM_FLAG		0
+#endif /* CONFIG_BUTTON_ISR_IRAM */
+
+#define BUTTON_ISR_FLAGS	((ESP_INTR_FLAG_LEVEL1 << (CONFIG_BUTTON_ISR_LEVEL - 1)) | \
+	BUTTON_ISR_SHARED_FLAG | BUTTON_ISR_IRAM_FLAG)
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE */
+
+/* GPIO level of a pressed button */
+#define BUTTON_ACTIVE_LEVEL(me)	((me)->edge == BUTTON_EDGE_FALLING ? 0 : 1)
+
+#ifdef CONFIG_BUTTON_WAKEUP
+/* GPIO interrupt types of the press and the release, the press level is also
+ * the light sleep wakeup level. The ISR disables the interrupt at the first
+ * trigger, so a level interrupt is handled as an edge */
+#define BUTTON_PRESS_INTR(me)		((me)->edge == BUTTON_EDGE_FALLING ? \
+	GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL)
+#define BUTTON_RELEASE_INTR(me)	((me)->edge == BUTTON_EDGE_FALLING ? \
+	GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL)
+#elif defined(CONFIG_BUTTON_ENGINE_TIMERS)
+/* GPIO interrupt types of the press and the release edges */
+#define BUTTON_PRESS_INTR(me)		((me)->edge == BUTTON_EDGE_FALLING ? \
+	GPIO_INTR_NEGEDGE : GPIO_INTR_POSEDGE)
+#define BUTTON_RELEASE_INTR(me)	((me)->edge == BUTTON_EDGE_FALLING ? \
+	GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE)
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+/* Event path logs, compiled in up to CONFIG_BUTTON_LOG_LEVEL */
+#if CONFIG_BUTTON_LOG_LEVEL >= 2
+#define BUTTON_LOGW(format, ...)	ESP_LOGW(TAG, format, ##__VA_ARGS__)
+#else
+#define BUTTON_LOGW(format, ...)	do {} while (0)
+#endif /* CONFIG_BUTTON_LOG_LEVEL >= 2 */
+
+#if CONFIG_BUTTON_LOG_LEVEL >= 3
+#define BUTTON_LOGI(format, ...)	ESP_LOGI(TAG, format, ##__VA_ARGS__)
+#else
+#define BUTTON_LOGI(format, ...)	do {} while (0)
+#endif /* CONFIG_BUTTON_LOG_LEVEL >= 3 */
+
+#if CONFIG_BUTTON_LOG_LEVEL >= 4
+#define BUTTON_ISR_LOGD(format, ...)	ESP_DRAM_LOGD(TAG, format, ##__VA_ARGS__)
+#else
+#define BUTTON_ISR_LOGD(format, ...)	do {} while (0)
+#endif /* CONFIG_BUTTON_LOG_LEVEL >= 4 */
 
 /* Private function prototypes -----------------------------------------------*/
-static void IRAM_ATTR isr_handler(void * arg);
+static esp_err_t button_setup(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		const button_config_t *const config, button_static_t *const buffers);
+static void button_teardown(button_t *const me);
+static esp_err_t button_config_apply(button_t *const me,
+		const button_config_t *const config);
+#ifndef CONFIG_BUTTON_DISPATCH_PULL
 static void button_task (void * arg);
-
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+static esp_err_t button_glitch_filter_init(button_t *const me);
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+#if (defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)) && \
+		CONFIG_BUTTON_ISR_CORE_ID >= 0
+static void button_isr_service_install_ipc(void *arg);
+#endif /* (CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE) && CONFIG_BUTTON_ISR_CORE_ID >= 0 */
+
+#ifdef CONFIG_BUTTON_REGISTRY
+static esp_err_t button_register(button_t *const me);
+static void button_unregister(button_t *const me);
+#ifdef CONFIG_BUTTON_TASK_MODE_SERVICE
+static button_t *button_lookup(const button_event_t *event);
+#endif /* CONFIG_BUTTON_TASK_MODE_SERVICE */
+#endif /* CONFIG_BUTTON_REGISTRY */
+
+static void ring_init(button_ring_t *const ring, button_ring_slot_t *slots,
+		uint32_t size);
+static bool IRAM_ATTR ring_push(button_ring_t *const ring,
+		const button_event_t *event);
+static bool ring_pop(button_ring_t *const ring, button_event_t *event);
+
+static void IRAM_ATTR button_post_event(button_t *const me,
+		button_click_e click_type, uint8_t count, button_time_t timestamp,
+		bool from_isr);
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+static bool button_pull(button_pull_event_t *const record);
+#else
+static void button_dispatch(button_t *const me, button_click_e click_type,
+		uint8_t count, button_time_t timestamp);
+static void button_execute(button_t *const me,
+		const button_function_t *function, button_click_e click_type,
+		uint8_t count, button_time_t timestamp);
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+static esp_err_t button_event_handler_init(void);
+static void button_event_handler(void *arg, esp_event_base_t base, int32_t id,
+		void *data);
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+#ifdef CONFIG_BUTTON_STATS
+static void button_stats_init(button_t *const me);
+#endif /* CONFIG_BUTTON_STATS */
+#ifdef CONFIG_BUTTON_FOOTPRINT_REPORT
+static void button_footprint_report(uint32_t task_stack_size);
+#endif /* CONFIG_BUTTON_FOOTPRINT_REPORT */
+#ifdef CONFIG_BUTTON_COMBO
+static esp_err_t button_combo_add(button_t *const *members, uint8_t num,
+		bool sequence, uint32_t time, bool suppress, button_cb_t function,
+		void *arg);
+static void IRAM_ATTR button_combo_post(button_t *const me, bool was_pressed,
+		button_time_t now);
+static void button_combo_update(uint8_t id, bool pressed,
+		button_time_t timestamp);
+static TickType_t button_combo_tick(void);
+static void button_combo_replay(button_time_t until);
+static void button_combo_drop(uint8_t id);
+#endif /* CONFIG_BUTTON_COMBO */
+#ifdef CONFIG_BUTTON_TRACE
+static inline void IRAM_ATTR button_trace(const button_t *const me,
+		bool pressed, button_core_event_t event, button_time_t now);
+#endif /* CONFIG_BUTTON_TRACE */
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+static void IRAM_ATTR button_isr_dispatch(button_t *const me,
+		button_click_e click_type);
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+static void IRAM_ATTR isr_handler(void * arg);
+static void IRAM_ATTR button_edge_from_isr(button_t *const me,
+		button_time_t now);
 static void debounce_timer_handler(TimerHandle_t timer);
 static void click_timer_handler(TimerHandle_t timer);
+static void button_schedule(button_t *const me, button_time_t now);
+static void button_timer_call(void (*function)(void *arg), void *arg);
+static void button_timer_call_cb(void *arg1, uint32_t arg2);
+static void button_config_call(void *arg);
+static void button_gestures_call(void *arg);
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+static void IRAM_ATTR button_debounce_adapt(button_t *const me,
+		button_core_time_t bounce);
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+#else
+static void scan_timer_handler(void *arg);
+static void button_scan(button_t *const me, button_time_t now);
+static void button_scan_post(button_t *const me, button_core_event_t event,
+		button_time_t now);
+#ifdef CONFIG_BUTTON_GROUP
+static void button_group_scan(button_group_t *const me, button_time_t now);
+#endif /* CONFIG_BUTTON_GROUP */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifdef CONFIG_BUTTON_WAKEUP
+static esp_err_t button_wakeup_init(button_t *const me);
+static void button_wakeup_deinit(button_t *const me);
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static esp_err_t button_sleep_exit_cb(int64_t sleep_time_us, void *arg);
+#endif /* CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+static esp_err_t button_ext1_update(void);
+static void button_wakeup_replay(button_t *const me);
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+#endif /* CONFIG_BUTTON_WAKEUP */
 
 /* Private variables ---------------------------------------------------------*/
 /* Tag for debug */
 static const char * TAG = "button";
 
+/* Lock of the callback tables, held only to copy or edit them */
+static portMUX_TYPE function_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Thresholds of the buttons initialized without config */
+static const button_config_t default_config = BUTTON_CONFIG_DEFAULT();
+
+#ifdef CONFIG_BUTTON_DISPATCH_EXECUTOR
+/* Application executor of the callbacks */
+static button_executor_t executor = NULL;
+static void *executor_arg = NULL;
+#endif /* CONFIG_BUTTON_DISPATCH_EXECUTOR */
+
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+/* Button event base */
+ESP_EVENT_DEFINE_BASE(BUTTON_EVENT);
+
+/* Button event handler registered in the default event loop */
+static bool event_handler_registered = false;
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_SERVICE
+/* Button service variables */
+static button_ring_t service_ring;
+static button_ring_slot_t service_ring_slots[CONFIG_BUTTON_SERVICE_QUEUE_SIZE];
+#ifndef CONFIG_BUTTON_DISPATCH_PULL
+static StaticTask_t service_task_buffer;
+static StackType_t service_task_stack[CONFIG_BUTTON_SERVICE_TASK_STACK_SIZE];
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+/* Button whose callbacks the service task is running, or whose event the
+ * application is reading */
+static button_t *dispatching = NULL;
+#endif /* CONFIG_BUTTON_TASK_MODE_SERVICE */
+
+#ifdef CONFIG_BUTTON_COMBO
+/* Registered combinations, edited under function_lock */
+static button_combo_t combos[CONFIG_BUTTON_MAX_COMBOS];
+static uint8_t combos_num = 0;
+
+/* Pressed buttons and buttons with the clicks dropped, bit per button id */
+static uint64_t combo_pressed = 0;
+static uint64_t combo_suppressed = 0;
+
+/* Press and release events, apart from the clicks so they never take the
+ * slots of the service ring, and the next one read by the service task */
+static button_ring_t combo_ring;
+static button_ring_slot_t combo_ring_slots[CONFIG_BUTTON_COMBO_QUEUE_SIZE];
+static button_event_t combo_event;
+static bool combo_held = false;
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_TRACE
+/* Edge trace ring of all the buttons, the head counts the records written */
+static button_trace_record_t trace_ring[CONFIG_BUTTON_TRACE_SIZE];
+static uint32_t trace_head = 0;
+
+_Static_assert(sizeof(button_trace_record_t) == 8,
+		"button_trace_record_t is the export format");
+#endif /* CONFIG_BUTTON_TRACE */
+
+#ifdef CONFIG_BUTTON_REGISTRY
+/* Registered buttons */
+static button_t *buttons[CONFIG_BUTTON_MAX_BUTTONS];
+static uint8_t buttons_num = 0;
+
+/* Registrations of each button index, the events still queued for a previous
+ * button of the index are dropped */
+static uint8_t generations[CONFIG_BUTTON_MAX_BUTTONS];
+#endif /* CONFIG_BUTTON_REGISTRY */
+
+#ifdef CONFIG_BUTTON_ENGINE_SCAN
+/* Shared scan timer */
+static esp_timer_handle_t scan_timer = NULL;
+
+/* Scans completed, button_deinit() waits for the running one */
+static uint32_t scan_passes = 0;
+
+#ifdef CONFIG_BUTTON_GROUP
+/* Registered button groups */
+static button_group_t *groups = NULL;
+#endif /* CONFIG_BUTTON_GROUP */
+#endif /* CONFIG_BUTTON_ENGINE_SCAN */
+
+#if defined(CONFIG_BUTTON_WAKEUP) && defined(CONFIG_PM_LIGHT_SLEEP_CALLBACKS)
+/* Light sleep exit callback registered */
+static bool sleep_cb_registered = false;
+#endif /* CONFIG_BUTTON_WAKEUP && CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+/* Button pins of the EXT1 wakeup source, all of them with the same edge */
+static uint64_t ext1_mask = 0;
+static button_edge_e ext1_edge;
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+
 /* Exported functions --------------------------------------------------------*/
+#if configSUPPORT_DYNAMIC_ALLOCATION
 esp_err_t button_init(button_t *const me, gpio_num_t gpio, button_edge_e edge,
 		UBaseType_t task_priority, uint32_t task_stack_size) {
-	ESP_LOGI(TAG, "Initializing button component...");
-
-	/* Error code variable */
-	esp_err_t ret = ESP_OK;
+	return button_setup(me, gpio, edge, task_priority, task_stack_size, NULL,
+			NULL);
+}
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+esp_err_t button_init_static(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		button_static_t *const buffers) {
+	/* Check buffers argument */
+	if (buffers == NULL) {
+		ESP_LOGE(TAG, "Invalid buffers argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	/* Initialize callback variables */
-	for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
-		me->function[i].function = NULL;
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	if (buffers->task_stack == NULL) {
+		ESP_LOGE(TAG, "Invalid task stack argument");
+		return ESP_ERR_INVALID_ARG;
 	}
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
 
-	/* Create button event group */
-	me->event_group = xEventGroupCreate();
+	return button_setup(me, gpio, edge, task_priority, task_stack_size, NULL,
+			buffers);
+}
 
-	if (me->event_group == NULL) {
-		ESP_LOGE(TAG, "Failed to allocate memory to create event group");
-		return ESP_ERR_NO_MEM;
+esp_err_t button_init_config(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		const button_config_t *const config, button_static_t *const buffers) {
+#if !configSUPPORT_DYNAMIC_ALLOCATION
+	/* Check buffers argument, there is no heap to allocate from */
+	if (buffers == NULL) {
+		ESP_LOGE(TAG, "Invalid buffers argument");
+		return ESP_ERR_INVALID_ARG;
 	}
+#endif /* !configSUPPORT_DYNAMIC_ALLOCATION */
 
-	/* Initialize button GPIO */
-	if (gpio < GPIO_NUM_0 || gpio >= GPIO_NUM_MAX) {
-		ESP_LOGE(TAG, "Invalid GPIO number");
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	if (buffers != NULL && buffers->task_stack == NULL) {
+		ESP_LOGE(TAG, "Invalid task stack argument");
 		return ESP_ERR_INVALID_ARG;
 	}
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
 
-	me->gpio = gpio;
+	return button_setup(me, gpio, edge, task_priority, task_stack_size, config,
+			buffers);
+}
 
-	gpio_config_t gpio_conf;
-	gpio_conf.pin_bit_mask = 1ULL << me->gpio;
-	gpio_conf.mode = GPIO_MODE_INPUT;
+esp_err_t button_deinit(button_t *const me) {
+	ESP_LOGI(TAG, "Deinitializing button component...");
 
-	me->edge = edge;
+	if (me == NULL) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	if (me->edge == BUTTON_EDGE_FALLING) {
-		gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-		gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-		me->state = BUTTON_STATE_DOWN;
-		gpio_conf.intr_type = GPIO_INTR_NEGEDGE;
+#ifdef CONFIG_BUTTON_GROUP
+	if (me->grouped) {
+		ESP_LOGE(TAG, "Grouped buttons can not be deinitialized");
+		return ESP_ERR_NOT_SUPPORTED;
 	}
-	else if (me->edge == BUTTON_EDGE_RISING) {
-		gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-		gpio_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
-		me->state = BUTTON_STATE_UP;
-		gpio_conf.intr_type = GPIO_INTR_POSEDGE;
+#endif /* CONFIG_BUTTON_GROUP */
+
+#if !defined(CONFIG_BUTTON_DISPATCH_PULL) || defined(CONFIG_BUTTON_ENGINE_TIMERS)
+	/* The tasks running the callbacks can not wait for themselves */
+	TaskHandle_t task = xTaskGetCurrentTaskHandle();
+#endif
+
+#ifndef CONFIG_BUTTON_DISPATCH_PULL
+	if (task == BUTTON_RING(me)->task) {
+		ESP_LOGE(TAG, "Button can not be deinitialized from its callbacks");
+		return ESP_ERR_INVALID_STATE;
 	}
-	else {
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	if (task == xTimerGetTimerDaemonTaskHandle()) {
+		ESP_LOGE(TAG, "Button can not be deinitialized from its callbacks");
+		return ESP_ERR_INVALID_STATE;
+	}
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+	/* Undo button_init() in reverse order */
+	button_teardown(me);
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+#ifdef CONFIG_BUTTON_GROUP
+esp_err_t button_group_init(button_group_t *const me, uint64_t gpio_mask,
+		button_edge_e edge, button_t *buttons) {
+	ESP_LOGI(TAG, "Initializing button group...");
+
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+	/* Check arguments, all the pins must be in the same GPIO bank */
+	if (buttons == NULL || gpio_mask == 0 || (gpio_mask >> GPIO_NUM_MAX) != 0) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if ((uint32_t)gpio_mask != 0 && (gpio_mask >> 32) != 0) {
+		ESP_LOGE(TAG, "Group pins must be in the same GPIO bank");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (edge != BUTTON_EDGE_FALLING && edge != BUTTON_EDGE_RISING) {
 		ESP_LOGE(TAG, "Invalid mode");
 		return ESP_ERR_INVALID_ARG;
 	}
 
+	/* Configure all the group pins at once */
+	gpio_config_t gpio_conf = {
+			.pin_bit_mask = gpio_mask,
+			.mode = GPIO_MODE_INPUT,
+			.pull_up_en = edge == BUTTON_EDGE_FALLING ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+			.pull_down_en = edge == BUTTON_EDGE_RISING ? GPIO_PULLDOWN_ENABLE : GPIO_PULLDOWN_DISABLE,
+			.intr_type = GPIO_INTR_DISABLE
+	};
+
 	ret = gpio_config(&gpio_conf);
 
 	if (ret != ESP_OK) {
@@ -118,368 +611,2442 @@ esp_err_t button_init(button_t *const me, gpio_num_t gpio, button_edge_e edge,
 		return ret;
 	}
 
-	/* Install ISR service and add ISR handler */
-	ret = gpio_install_isr_service(0);
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+	ret = button_event_handler_init();
 
-	if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-		ESP_LOGE(TAG, "Failed to install GPIO ISR service");
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to register event handler");
 		return ret;
 	}
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+
+	/* Initialize group variables with the idle levels */
+	me->bank = (uint32_t)gpio_mask != 0 ? 0 : 1;
+	me->mask = me->bank == 0 ? (uint32_t)gpio_mask : (uint32_t)(gpio_mask >> 32);
+	me->active_level = edge == BUTTON_EDGE_FALLING ? 0 : 1;
+	me->levels = me->active_level ? 0 : me->mask;
+	me->count0 = 0;
+	me->count1 = 0;
+	me->clicks = 0;
+	me->buttons = buttons;
+
+	/* Initialize and register the group buttons */
+	uint32_t pins = me->mask;
+
+	for (button_t *button = buttons; pins != 0; button++, pins &= pins - 1) {
+		button_callbacks_init(&button->callbacks);
+
+		for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
+			button->pending[i] = 0;
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+			button->isr_function[i].function = NULL;
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+		}
 
-	ret = gpio_isr_handler_add(me->gpio, isr_handler, (void *)me);
+		button->click_mask = BUTTON_CLICK_MASK_INIT;
+		button->event_count = 0;
+		button->click_count = 0;
+		button_config_apply(button, &default_config);
+
+		button->gpio = (gpio_num_t)(__builtin_ctz(pins) + me->bank * 32);
+		button->edge = edge;
+		button_core_init(&button->core);
+		button->grouped = true;
+		button->id = CONFIG_BUTTON_MAX_BUTTONS;
+#ifdef CONFIG_BUTTON_STATS
+		button_stats_init(button);
+#endif /* CONFIG_BUTTON_STATS */
+
+		ret = button_register(button);
+
+		if (ret != ESP_OK) {
+			/* Unregister the buttons of the group registered so far */
+			while (button != buttons) {
+				button_unregister(--button);
+			}
 
-	if (ret != ESP_OK) {
-		ESP_LOGE(TAG, "Failed to add GPIO ISR handler");
-		return ret;
+			return ret;
+		}
 	}
 
-	/* Initialize tick counter variable */
-	me->tick_counter = 0;
+	/* Publish the group to the scan timer */
+	me->next = groups;
+	__atomic_store_n(&groups, me, __ATOMIC_RELEASE);
 
-	/* Initialize button task variables */
-	me->task_priority = task_priority;
-	me->task_stack_size = task_stack_size;
+	/* Return ESP_OK */
+	return ret;
+}
+#endif /* CONFIG_BUTTON_GROUP */
 
-	/* Create RTOS task */
-	if (xTaskCreate(button_task,
-			"Button Task",
-			me->task_stack_size,
-			(void *)me,
-			me->task_priority,
-			NULL) != pdPASS) {
+esp_err_t button_add_cb(button_t *const me, button_click_e click_type,
+		button_cb_t function, void *arg) {
+	ESP_LOGI(TAG, "Adding callback for button...");
 
-		ESP_LOGE(TAG, "Failed to allocate memory to create task");
-		return ESP_ERR_NO_MEM;
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+	ESP_LOGE(TAG, "Callbacks are not executed, read the events instead");
+	return ESP_ERR_NOT_SUPPORTED;
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+	esp_err_t ret = button_callbacks_add(&me->callbacks, &me->click_mask,
+			click_type, function, arg);
+
+	if (ret == ESP_ERR_INVALID_ARG) {
+		ESP_LOGI(TAG, "Invalid argument");
+	}
+	else if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Callback table is full");
 	}
 
-	/* Creater FreeRTOS software timer to filter button bounce */
-	me->debounce_timer = xTimerCreate("Debounce timer",
-			pdMS_TO_TICKS(CONFIG_BUTTON_DEBOUNCE_SHORT_TIME),
-			pdFALSE,
-			(void *)me,
-			debounce_timer_handler);
+	/* Return error code */
+	return ret;
+}
 
-	if (me->debounce_timer == NULL) {
-		ESP_LOGE(TAG, "Failed to allocate memory to timer");
-		return ESP_ERR_NO_MEM;
+esp_err_t button_remove_cb(button_t *const me, button_click_e click_type) {
+	ESP_LOGI(TAG, "Removing button callback function...");
+
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+	/* The click types read are selected with button_set_event_mask() */
+	if (click_type >= BUTTON_CLICK_SINGLE && click_type < BUTTON_CLICK_MAX) {
+		return ESP_ERR_NOT_SUPPORTED;
 	}
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
 
-	/* Creater FreeRTOS software timer to count the clicks number */
-	me->click_timer = xTimerCreate("Click timer",
-			pdMS_TO_TICKS(CONFIG_BUTTON_DEBOUNCE_SHORT_TIME * 8),
-			pdFALSE,
-			(void *)me,
-			click_timer_handler);
+	/* Stop posting the events of this click type */
+	esp_err_t ret = button_callbacks_remove(&me->callbacks, &me->click_mask,
+			click_type, NULL);
 
-	if (me->click_timer == NULL) {
-		ESP_LOGE(TAG, "Failed to allocate memory to timer");
-		return ESP_ERR_NO_MEM;
+	if (ret != ESP_OK) {
+		ESP_LOGI(TAG, "Invalid mode");
 	}
 
-	/* Return ESP_OK */
+	/* Return error code */
 	return ret;
 }
 
-esp_err_t button_add_cb(button_t *const me, button_click_e click_type,
-		button_cb_t function, void *arg) {
-	ESP_LOGI(TAG, "Adding callback for button...");
+esp_err_t button_remove_cb_function(button_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg) {
+	ESP_LOGI(TAG, "Removing button callback function...");
 
-	/* Error code variable */
-	esp_err_t ret = ESP_OK;
+	const button_function_t entry = {
+			.function = function,
+			.arg = arg
+	};
 
-	/* Check function argument */
-	if (function == NULL) {
-		ESP_LOGI(TAG, "Invalid function argument");
-		return ESP_ERR_INVALID_ARG;
-	}
+	esp_err_t ret = button_callbacks_remove(&me->callbacks, &me->click_mask,
+			click_type, &entry);
 
-	if (click_type < BUTTON_CLICK_SINGLE || click_type >= BUTTON_CLICK_MAX) {
+	if (ret == ESP_ERR_INVALID_ARG) {
 		ESP_LOGI(TAG, "Invalid mode");
-		ret = ESP_ERR_INVALID_ARG;
 	}
 
-	/* Assign function and argument values */
-	me->function[click_type].function = function;
-	me->function[click_type].arg = arg;
-
-	/* Return ESP_OK */
+	/* Return error code */
 	return ret;
 }
 
-esp_err_t button_remove_cb(button_t *const me, button_click_e click_type) {
-	ESP_LOGI(TAG, "Removing button callback function...");
+uint8_t button_get_event_count(const button_t *const me) {
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+	const button_work_t *work = (const button_work_t *)
+			pvTaskGetThreadLocalStoragePointer(NULL, CONFIG_BUTTON_TLS_INDEX);
 
-	/* Error code variable */
-	esp_err_t ret = ESP_OK;
+	if (work != NULL && work->button == me) {
+		return work->events;
+	}
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
 
-	if (click_type < BUTTON_CLICK_SINGLE || click_type >= BUTTON_CLICK_MAX) {
-		ESP_LOGI(TAG, "Invalid mode");
-		ret = ESP_ERR_INVALID_ARG;
+	return me->event_count;
+}
+
+uint8_t button_get_click_count(const button_t *const me) {
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+	const button_work_t *work = (const button_work_t *)
+			pvTaskGetThreadLocalStoragePointer(NULL, CONFIG_BUTTON_TLS_INDEX);
+
+	if (work != NULL && work->button == me) {
+		return work->count;
 	}
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
 
-	/* Assign function and argument values */
-	me->function[click_type].function = NULL;
-	me->function[click_type].arg = NULL;
+	return me->click_count;
+}
+
+#ifdef CONFIG_BUTTON_DISPATCH_EXECUTOR
+esp_err_t button_set_executor(button_executor_t executor_function, void *arg) {
+	/* The argument is published before the executor that reads it */
+	__atomic_store_n(&executor_arg, arg, __ATOMIC_RELAXED);
+	__atomic_store_n(&executor, executor_function, __ATOMIC_RELEASE);
 
 	/* Return ESP_OK */
-	return ret;
+	return ESP_OK;
 }
-/* Private functions ---------------------------------------------------------*/
-static void isr_handler(void *arg) {
-	button_t *button = (button_t *)arg;
+#endif /* CONFIG_BUTTON_DISPATCH_EXECUTOR */
+
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+void button_work_run(const button_work_t *work) {
+	/* The callback reads the counters of its own event from the storage of the
+	 * calling task, the button ones belong to the button task */
+	void *previous = pvTaskGetThreadLocalStoragePointer(NULL,
+			CONFIG_BUTTON_TLS_INDEX);
+
+	vTaskSetThreadLocalStoragePointer(NULL, CONFIG_BUTTON_TLS_INDEX,
+			(void *)work);
+	work->function.function(work->function.arg);
+	vTaskSetThreadLocalStoragePointer(NULL, CONFIG_BUTTON_TLS_INDEX, previous);
+}
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
+
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+esp_err_t button_get_event(button_pull_event_t *const event,
+		TickType_t timeout) {
+	/* Check arguments */
+	if (event == NULL) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	static TickType_t elapsed_time = 0;
+	/* Notify the calling task of the next posted event, before checking the
+	 * ring so that no event is missed */
+	__atomic_store_n(&service_ring.task, xTaskGetCurrentTaskHandle(),
+			__ATOMIC_SEQ_CST);
 
-	switch (button->state) {
-		case BUTTON_STATE_DOWN:
-			/* Disable button interrupt */
-			gpio_set_intr_type(button->gpio, GPIO_INTR_DISABLE);
+	TimeOut_t time_out;
 
-			if (button->edge == BUTTON_EDGE_FALLING) {
-				/* Get initial tick counter */
-				button->tick_counter = xTaskGetTickCountFromISR();
-			}
-			else {
-				/* Calculate and print button elapsed time pressed */
-				elapsed_time = pdTICKS_TO_MS(xTaskGetTickCountFromISR() - button->tick_counter);
-#ifdef BUTTON_ENABLE_DEBUG
-				ESP_DRAM_LOGI(TAG, "button %d pressed for %d ms", button->gpio, elapsed_time);
-#endif /* BUTTON_ENABLE_DEBUG */
-
-				/* Execute function callback according button elapsed time pressed */
-				if (elapsed_time >= CONFIG_BUTTON_DEBOUNCE_SHORT_TIME && elapsed_time < CONFIG_BUTTON_DEBOUNCE_MEDIUM_TIME) {
-					/* Increment click counter */
-					button->click_counter++;
-
-					if (button->click_counter == 2) {
-						button->click_counter = 0;
-						xEventGroupSetBitsFromISR(button->event_group, BUTTON_DOUBLE_CLICK_PRESS_BIT, NULL);
-					}
-
-					/* Start click timer */
-					xTimerStartFromISR(button->click_timer, NULL);
-				}
-				else if ((elapsed_time >= CONFIG_BUTTON_DEBOUNCE_MEDIUM_TIME && elapsed_time < CONFIG_BUTTON_DEBOUNCE_LONG_TIME)) {
-					xEventGroupSetBitsFromISR(button->event_group, BUTTON_MEDIUM_PRESS_BIT, NULL);
-				}
-				else if (elapsed_time >= CONFIG_BUTTON_DEBOUNCE_LONG_TIME) {
-					xEventGroupSetBitsFromISR(button->event_group, BUTTON_LONG_PRESS_BIT, NULL);
-				}
-				else {
-#ifdef BUTTON_ENABLE_DEBUG
-					ESP_DRAM_LOGI(TAG, "button %d bounce", button->gpio);
-#endif /* BUTTON_ENABLE_DEBUG */
-					break;
-				}
+	vTaskSetTimeOutState(&time_out);
 
-				/* Reset button elapsed time pressed */
-				elapsed_time = 0;
-			}
+	while (!button_pull(event)) {
+		if (xTaskCheckForTimeOut(&time_out, &timeout) == pdTRUE) {
+			return ESP_ERR_TIMEOUT;
+		}
+
+		ulTaskNotifyTake(pdTRUE, timeout);
+	}
 
-			/* Start debounce timer */
-			xTimerStartFromISR(button->debounce_timer, NULL);
+	/* Return ESP_OK */
+	return ESP_OK;
+}
 
-			break;
+size_t button_poll_events(button_pull_event_t *const events, size_t num) {
+	size_t read = 0;
 
-		case BUTTON_STATE_UP:
-			/* Disable button interrupt */
-			gpio_set_intr_type(button->gpio, GPIO_INTR_DISABLE);
+	if (events == NULL) {
+		return 0;
+	}
 
-			if (button->edge == BUTTON_EDGE_FALLING) {
-				/* Calculate and print button elapsed time pressed */
-				elapsed_time = pdTICKS_TO_MS(xTaskGetTickCountFromISR() - button->tick_counter);
-#ifdef BUTTON_ENABLE_DEBUG
-				ESP_DRAM_LOGI(TAG, "button %d pressed for %d ms", button->gpio, elapsed_time);
-#endif /* BUTTON_ENABLE_DEBUG */
+	while (read < num && button_pull(&events[read])) {
+		read++;
+	}
 
-				/* Execute function callback according button elapsed time pressed */
-				if (elapsed_time >= CONFIG_BUTTON_DEBOUNCE_SHORT_TIME && elapsed_time < CONFIG_BUTTON_DEBOUNCE_MEDIUM_TIME) {
-					/* Increment click counter */
-					button->click_counter++;
+	return read;
+}
 
-					if (button->click_counter == 2) {
-						button->click_counter = 0;
-						xEventGroupSetBitsFromISR(button->event_group, BUTTON_DOUBLE_CLICK_PRESS_BIT, NULL);
-					}
+esp_err_t button_set_event_mask(button_t *const me, uint8_t mask) {
+	/* Check arguments */
+	if (me == NULL || mask >= (1 << BUTTON_CLICK_MAX)) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-					/* Start click timer */
-					xTimerStartFromISR(button->click_timer, NULL);
-				}
-				else if ((elapsed_time >= CONFIG_BUTTON_DEBOUNCE_MEDIUM_TIME && elapsed_time < CONFIG_BUTTON_DEBOUNCE_LONG_TIME)) {
-					xEventGroupSetBitsFromISR(button->event_group, BUTTON_MEDIUM_PRESS_BIT, NULL);
-				}
-				else if (elapsed_time >= CONFIG_BUTTON_DEBOUNCE_LONG_TIME) {
-					xEventGroupSetBitsFromISR(button->event_group, BUTTON_LONG_PRESS_BIT, NULL);
-				}
-				else {
-#ifdef BUTTON_ENABLE_DEBUG
-					ESP_DRAM_LOGI(TAG, "button %d bounce", button->gpio);
-#endif /* BUTTON_ENABLE_DEBUG */
-					break;
-				}
+	__atomic_store_n(&me->click_mask, mask, __ATOMIC_RELEASE);
 
-				/* Reset button elapsed time pressed */
-				elapsed_time = 0;
-			}
-			else {
-				/* Get initial tick counter */
-				button->tick_counter = xTaskGetTickCountFromISR();
-			}
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
 
-			/* Start debounce timer */
-			xTimerStartFromISR(button->debounce_timer, NULL);
+esp_err_t button_set_config(button_t *const me,
+		const button_config_t *const config) {
+	/* Check arguments */
+	if (me == NULL || config == NULL) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-			break;
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Mask the interrupt and apply the config in the timer task, between two
+	 * timer callbacks, so neither the ISR nor a timer reads it half written */
+	button_config_arg_t arg = {
+			.button = me,
+			.config = config,
+			.ret = ESP_OK
+	};
+
+	gpio_intr_disable(me->gpio);
+	button_timer_call(button_config_call, &arg);
+	gpio_intr_enable(me->gpio);
+
+	esp_err_t ret = arg.ret;
+#else
+	/* The scan timer reads the config without a lock */
+	esp_err_t ret = button_config_apply(me, config);
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
 
-		default:
-			break;
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid config argument");
 	}
 
-	portYIELD_FROM_ISR();
+	return ret;
 }
 
-static void button_task(void *arg) {
-	button_t *button = (button_t *)arg;
-	EventBits_t bits;
-	const EventBits_t bits_wait_for = (BUTTON_SHORT_PRESS_BIT |
-			BUTTON_MEDIUM_PRESS_BIT |
-			BUTTON_LONG_PRESS_BIT |
-			BUTTON_DOUBLE_CLICK_PRESS_BIT);
+esp_err_t button_set_gestures(button_t *const me, uint8_t max_clicks,
+		uint32_t repeat_delay, uint32_t repeat_period) {
+	/* Check arguments */
+	if (me == NULL ||
+			!BUTTON_GESTURES_VALID(max_clicks, repeat_delay, repeat_period)) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	for (;;) {
-		/* Wait until some bit is set */
-		bits = xEventGroupWaitBits(button->event_group,
-				bits_wait_for,
-				pdTRUE,
-				pdFALSE,
-				portMAX_DELAY);
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Mask the interrupt and apply the gestures in the timer task, like
+	 * button_set_config() */
+	button_gestures_arg_t arg = {
+			.button = me,
+			.max_clicks = max_clicks,
+			.repeat_delay = (button_core_time_t)repeat_delay * 1000,
+			.repeat_period = (button_core_time_t)repeat_period * 1000
+	};
+
+	gpio_intr_disable(me->gpio);
+	button_timer_call(button_gestures_call, &arg);
+	gpio_intr_enable(me->gpio);
+#else
+	/* The scan timer reads the config without a lock */
+	me->config.max_clicks = max_clicks;
+	me->config.repeat_delay = (button_core_time_t)repeat_delay * 1000;
+	me->config.repeat_period = (button_core_time_t)repeat_period * 1000;
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
 
-		if (bits & BUTTON_SHORT_PRESS_BIT) {
-			ESP_LOGI(TAG, "BUTTON_SHORT_PRESS_BIT set");
+	/* Return ESP_OK */
+	return ESP_OK;
+}
 
-			/* Execute callback function */
-			if (button->function[BUTTON_CLICK_SINGLE].function != NULL) {
-				button->function[BUTTON_CLICK_SINGLE].function(button->function[BUTTON_CLICK_SINGLE].arg);
-			}
-			else {
-				ESP_LOGW(TAG, "Function callback not added");
-			}
-		}
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+uint32_t button_get_debounce_time(const button_t *const me) {
+	return me->config.short_time;
+}
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
 
-		else if (bits & BUTTON_MEDIUM_PRESS_BIT) {
-			ESP_LOGI(TAG, "BUTTON_MEDIUM_PRESS_BIT set");
+#ifdef CONFIG_BUTTON_STATS
+esp_err_t button_get_stats(button_t *const me, button_stats_t *const stats) {
+	/* Check arguments */
+	if (me == NULL || stats == NULL) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-			/* Execute callback function */
-			if (button->function[BUTTON_CLICK_MEDIUM].function != NULL) {
-				button->function[BUTTON_CLICK_MEDIUM].function(button->function[BUTTON_CLICK_MEDIUM].arg);
-			}
-			else {
-				ESP_LOGW(TAG, "Function callback not added");
-			}
-		}
-		else if (bits & BUTTON_LONG_PRESS_BIT) {
-			ESP_LOGI(TAG, "BUTTON_LONG_PRESS_BIT set");
+	*stats = me->stats;
 
-			/* Execute callback function */
-			if (button->function[BUTTON_CLICK_LONG].function != NULL) {
-				button->function[BUTTON_CLICK_LONG].function(button->function[BUTTON_CLICK_LONG].arg);
-			}
-			else {
-				ESP_LOGW(TAG, "Function callback not added");
-			}
-		}
-		else if (bits & BUTTON_DOUBLE_CLICK_PRESS_BIT) {
-			ESP_LOGI(TAG, "BUTTON_DOUBLE_CLICK_PRESS_BIT set");
+	/* Compute the averages, report zero instead of the initial minimums */
+	for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
+		button_click_stats_t *click = &stats->click[i];
 
-			/* Execute callback function */
-			if (button->function[BUTTON_CLICK_DOUBLE].function != NULL) {
-				button->function[BUTTON_CLICK_DOUBLE].function(button->function[BUTTON_CLICK_DOUBLE].arg);
-			}
-			else {
-				ESP_LOGW(TAG, "Function callback not added");
-			}
+		if (click->count > 0) {
+			click->latency_avg = (uint32_t)(me->latency_sum[i] / click->count);
+			click->duration_avg = (uint32_t)(me->duration_sum[i] / click->count);
 		}
 		else {
-			ESP_LOGI(TAG, "Button unexpected event");
+			click->latency_min = 0;
+			click->duration_min = 0;
 		}
 	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
 }
+#endif /* CONFIG_BUTTON_STATS */
 
-static void debounce_timer_handler(TimerHandle_t timer) {
-	/* Get instance data */
-	button_t *button = (button_t *)pvTimerGetTimerID(timer);
+#ifdef CONFIG_BUTTON_TRACE
+size_t button_trace_dump(button_trace_record_t *const buffer, size_t size,
+		uint32_t *const seq) {
+	if (buffer == NULL) {
+		return 0;
+	}
 
-	/*  */
-	if (button->edge == BUTTON_EDGE_FALLING) {
-		if (button->state == BUTTON_STATE_DOWN) {
-			if (!gpio_get_level(button->gpio)) {
-				/* Change to next state */
-				button->state = BUTTON_STATE_UP;
+	/* Copy the newest records in one pass */
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+	uint32_t num = head < CONFIG_BUTTON_TRACE_SIZE ? head :
+			CONFIG_BUTTON_TRACE_SIZE;
 
-				/* Enable button interrupt to detect positive edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_POSEDGE);
-			}
-			else {
-				/* Enable button interrupt to detect negative edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_NEGEDGE);
-			}
+	if (num > size) {
+		num = size;
+	}
 
-		}
-		else {
-			if (gpio_get_level(button->gpio)) {
-				/* Change to next state */
-				button->state = BUTTON_STATE_DOWN;
+	uint32_t start = head - num;
 
-				/* Enable button interrupt to detect negative edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_NEGEDGE);
-			}
-			else {
-				/* Enable button interrupt to detect positive edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_POSEDGE);
-			}
-		}
+	for (uint32_t i = 0; i < num; i++) {
+		buffer[i] = trace_ring[(start + i) & (CONFIG_BUTTON_TRACE_SIZE - 1)];
 	}
-	else {
-		if (button->state == BUTTON_STATE_UP) {
-			if (gpio_get_level(button->gpio)) {
-				/* Change to next state */
-				button->state = BUTTON_STATE_DOWN;
 
-				/* Enable button interrupt to detect positive edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_NEGEDGE);
-			}
-			else {
-				/* Enable button interrupt to detect negative edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_POSEDGE);
-			}
+	/* Drop the oldest records overwritten during the copy */
+	uint32_t skip = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE) - start;
+
+	skip = skip > CONFIG_BUTTON_TRACE_SIZE ? skip - CONFIG_BUTTON_TRACE_SIZE : 0;
+
+	if (skip > num) {
+		skip = num;
+	}
+
+	/* Drop the newest records still being written */
+	uint32_t end = skip;
+
+	while (end < num && buffer[end].seq == (uint8_t)(start + end)) {
+		end++;
+	}
+
+	memmove(buffer, &buffer[skip], (end - skip) * sizeof(button_trace_record_t));
+
+	if (seq != NULL) {
+		*seq = start + skip;
+	}
+
+	return end - skip;
+}
+#endif /* CONFIG_BUTTON_TRACE */
+
+#ifdef CONFIG_BUTTON_COMBO
+esp_err_t button_add_chord(button_t *const *members, uint8_t num,
+		uint32_t hold_time, bool suppress, button_cb_t function, void *arg) {
+	return button_combo_add(members, num, false, hold_time, suppress, function,
+			arg);
+}
+
+esp_err_t button_add_sequence(button_t *const *members, uint8_t num,
+		uint32_t window, bool suppress, button_cb_t function, void *arg) {
+	return button_combo_add(members, num, true, window, suppress, function, arg);
+}
 
+esp_err_t button_remove_combo(button_cb_t function, void *arg) {
+	esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+	/* The last combination takes the place of the removed ones */
+	portENTER_CRITICAL(&function_lock);
+
+	for (uint8_t i = 0; i < combos_num;) {
+		if (combos[i].function.function == function &&
+				combos[i].function.arg == arg) {
+			combos[i] = combos[--combos_num];
+			ret = ESP_OK;
 		}
 		else {
-			if (!gpio_get_level(button->gpio)) {
-				/* Change to next state */
-				button->state = BUTTON_STATE_UP;
-
-				/* Enable button interrupt to detect negative edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_POSEDGE);
-			}
-			else {
-				/* Enable button interrupt to detect positive edge */
-				gpio_set_intr_type(button->gpio, GPIO_INTR_NEGEDGE);
-			}
+			i++;
 		}
 	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	return ret;
 }
+#endif /* CONFIG_BUTTON_COMBO */
 
-static void click_timer_handler(TimerHandle_t timer) {
-	/* Get instance data */
-	button_t *button = (button_t *)pvTimerGetTimerID(timer);
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+esp_err_t button_add_isr_cb(button_t *const me, button_click_e click_type,
+		button_cb_t function, void *arg) {
+	ESP_LOGI(TAG, "Adding ISR callback for button...");
+
+	/* Check function argument */
+	if (function == NULL) {
+		ESP_LOGI(TAG, "Invalid function argument");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	if (click_type < BUTTON_CLICK_SINGLE || click_type >= BUTTON_CLICK_MAX) {
+		ESP_LOGI(TAG, "Invalid mode");
+		return ESP_ERR_INVALID_ARG;
+	}
 
-	/* Single click */
-	if (button->click_counter == 1) {
-		button->click_counter = 0;
-		xEventGroupSetBitsFromISR(button->event_group, BUTTON_SHORT_PRESS_BIT, NULL);
+	/* Unpublish the previous function while the argument changes, so the ISR
+	 * never calls it with the new argument, then publish the new function */
+	__atomic_store_n(&me->isr_function[click_type].function, NULL,
+			__ATOMIC_SEQ_CST);
+	me->isr_function[click_type].arg = arg;
+	__atomic_store_n(&me->isr_function[click_type].function, function,
+			__ATOMIC_RELEASE);
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+esp_err_t button_remove_isr_cb(button_t *const me, button_click_e click_type) {
+	ESP_LOGI(TAG, "Removing button ISR callback function...");
+
+	if (click_type < BUTTON_CLICK_SINGLE || click_type >= BUTTON_CLICK_MAX) {
+		ESP_LOGI(TAG, "Invalid mode");
+		return ESP_ERR_INVALID_ARG;
 	}
+
+	/* Assign function and argument values */
+	__atomic_store_n(&me->isr_function[click_type].function, NULL,
+			__ATOMIC_RELEASE);
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+
+esp_err_t button_config_to_core(const button_config_t *const config,
+		uint32_t scan_period, button_core_config_t *const core) {
+	const button_config_t *thresholds = config != NULL ? config : &default_config;
+
+	/* Check the thresholds order */
+	if (core == NULL || !BUTTON_CONFIG_VALID(*thresholds)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Convert the times to microseconds, the edges are only compared */
+	core->short_time = (button_core_time_t)thresholds->debounce_time * 1000;
+	core->medium_time = (button_core_time_t)thresholds->medium_time * 1000;
+	core->long_time = (button_core_time_t)thresholds->long_time * 1000;
+	core->click_time = (button_core_time_t)thresholds->click_time * 1000;
+	core->repeat_delay = (button_core_time_t)thresholds->repeat_delay * 1000;
+	core->repeat_period = (button_core_time_t)thresholds->repeat_period * 1000;
+	core->max_clicks = thresholds->max_clicks;
+
+	/* Consecutive samples with the new level needed to accept a level change */
+	uint32_t samples = scan_period > 0 ? thresholds->debounce_time / scan_period : 1;
+
+	core->debounce_samples = samples < 1 ? 1 :
+			samples > BUTTON_CORE_MAX_SAMPLES ? BUTTON_CORE_MAX_SAMPLES : samples;
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+void button_callbacks_init(button_callbacks_t *const callbacks) {
+	for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
+		callbacks->num[i] = 0;
+	}
+}
+
+esp_err_t button_callbacks_add(button_callbacks_t *const callbacks,
+		uint8_t *const click_mask, button_click_e click_type, button_cb_t function,
+		void *arg) {
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+	if (function == NULL || click_type < BUTTON_CLICK_SINGLE ||
+			click_type >= BUTTON_CLICK_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Append the callback to the click type table */
+	portENTER_CRITICAL(&function_lock);
+
+	uint8_t num = callbacks->num[click_type];
+
+	if (num < CONFIG_BUTTON_MAX_CALLBACKS) {
+		callbacks->function[click_type][num].function = function;
+		callbacks->function[click_type][num].arg = arg;
+		callbacks->num[click_type] = num + 1;
+		__atomic_fetch_or(click_mask, 1 << click_type, __ATOMIC_RELEASE);
+	}
+	else {
+		ret = ESP_ERR_NO_MEM;
+	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	/* Return error code */
+	return ret;
+}
+
+esp_err_t button_callbacks_remove(button_callbacks_t *const callbacks,
+		uint8_t *const click_mask, button_click_e click_type,
+		const button_function_t *function) {
+	/* Error code variable */
+	esp_err_t ret = function != NULL ? ESP_ERR_NOT_FOUND : ESP_OK;
+
+	if (click_type < BUTTON_CLICK_SINGLE || click_type >= BUTTON_CLICK_MAX) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	portENTER_CRITICAL(&function_lock);
+
+	button_function_t *table = callbacks->function[click_type];
+	uint8_t num = callbacks->num[click_type];
+
+	if (function == NULL) {
+		num = 0;
+	}
+
+	for (uint8_t i = 0; i < num && ret != ESP_OK; i++) {
+		if (table[i].function == function->function && table[i].arg == function->arg) {
+			/* Move the last callback into the free entry */
+			table[i] = table[--num];
+			ret = ESP_OK;
+		}
+	}
+
+	callbacks->num[click_type] = num;
+
+	/* Stop posting the events of this click type */
+	if (num == 0) {
+		__atomic_fetch_and(click_mask, (uint8_t)~(1 << click_type),
+				__ATOMIC_RELEASE);
+	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	/* Return error code */
+	return ret;
+}
+
+uint8_t button_callbacks_copy(const button_callbacks_t *const callbacks,
+		button_click_e click_type, button_function_t *table) {
+	portENTER_CRITICAL(&function_lock);
+
+	uint8_t num = callbacks->num[click_type];
+
+	memcpy(table, callbacks->function[click_type], num * sizeof(button_function_t));
+	portEXIT_CRITICAL(&function_lock);
+
+	return num;
+}
+
+#if defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)
+esp_err_t button_isr_service_install(void) {
+#if CONFIG_BUTTON_ISR_CORE_ID >= 0
+	/* The interrupt is allocated on the core that installs the service */
+	esp_err_t ret = ESP_OK;
+	esp_err_t ipc_ret = esp_ipc_call_blocking(CONFIG_BUTTON_ISR_CORE_ID,
+			button_isr_service_install_ipc, (void *)&ret);
+
+	if (ipc_ret != ESP_OK) {
+		return ipc_ret;
+	}
+#else
+	esp_err_t ret = gpio_install_isr_service(BUTTON_ISR_FLAGS);
+#endif /* CONFIG_BUTTON_ISR_CORE_ID >= 0 */
+
+	/* A service already installed, by a backend or the application, is used as
+	 * it is */
+	return ret == ESP_ERR_INVALID_STATE ? ESP_OK : ret;
+}
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE */
+
+/* Private functions ---------------------------------------------------------*/
+static esp_err_t button_setup(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		const button_config_t *const config, button_static_t *const buffers) {
+	ESP_LOGI(TAG, "Initializing button component...");
+
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+#ifdef CONFIG_BUTTON_FOOTPRINT_REPORT
+	button_footprint_report(task_stack_size);
+#endif /* CONFIG_BUTTON_FOOTPRINT_REPORT */
+
+	/* Initialize callback variables */
+	button_callbacks_init(&me->callbacks);
+
+	for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
+		me->pending[i] = 0;
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+		me->isr_function[i].function = NULL;
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+	}
+
+	me->click_mask = BUTTON_CLICK_MASK_INIT;
+	me->event_count = 0;
+	me->click_count = 0;
+
+	/* Nothing to undo yet if a step fails */
+#ifdef CONFIG_BUTTON_REGISTRY
+	me->id = CONFIG_BUTTON_MAX_BUTTONS;
+#endif /* CONFIG_BUTTON_REGISTRY */
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	me->debounce_timer = NULL;
+	me->click_timer = NULL;
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+	me->glitch_filter = NULL;
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+	/* Convert the thresholds to the classifier time unit */
+	ret = button_config_apply(me, config != NULL ? config : &default_config);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid config argument");
+		return ret;
+	}
+
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+	ret = button_event_handler_init();
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to register event handler");
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+
+	/* Initialize button GPIO */
+	if (gpio < GPIO_NUM_0 || gpio >= GPIO_NUM_MAX) {
+		ESP_LOGE(TAG, "Invalid GPIO number");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	/* Initialize button event ring */
+	ring_init(&me->ring, me->ring_slots, CONFIG_BUTTON_TASK_QUEUE_SIZE);
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+
+	me->gpio = gpio;
+
+	gpio_config_t gpio_conf;
+	gpio_conf.pin_bit_mask = 1ULL << me->gpio;
+	gpio_conf.mode = GPIO_MODE_INPUT;
+
+	me->edge = edge;
+
+	if (me->edge == BUTTON_EDGE_FALLING) {
+		gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+		gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+		gpio_conf.intr_type = GPIO_INTR_NEGEDGE;
+	}
+	else if (me->edge == BUTTON_EDGE_RISING) {
+		gpio_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+		gpio_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
+		gpio_conf.intr_type = GPIO_INTR_POSEDGE;
+	}
+	else {
+		ESP_LOGE(TAG, "Invalid mode");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+#ifdef CONFIG_BUTTON_ENGINE_SCAN
+	/* The scan engine samples the GPIO level, no interrupt is needed */
+	gpio_conf.intr_type = GPIO_INTR_DISABLE;
+#elif defined(CONFIG_BUTTON_WAKEUP)
+	/* The press level interrupt also wakes up the chip */
+	gpio_conf.intr_type = BUTTON_PRESS_INTR(me);
+	me->armed = true;
+#elif defined(CONFIG_BUTTON_ISR_ANYEDGE)
+	/* Both edges are enabled once, the ISR drops the bounces */
+	gpio_conf.intr_type = GPIO_INTR_ANYEDGE;
+	me->armed = true;
+#endif /* CONFIG_BUTTON_ENGINE_SCAN */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Install ISR service, it is shared by all the buttons and kept */
+	ret = button_isr_service_install();
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to install GPIO ISR service");
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+	ret = gpio_config(&gpio_conf);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to configure GPIO");
+		return ret;
+	}
+
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+	/* Filter the glitches in hardware before they trigger an interrupt */
+	ret = button_glitch_filter_init(me);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to enable GPIO glitch filter");
+		button_teardown(me);
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+	/* Initialize the classifier with the button released */
+	button_core_init(&me->core);
+
+#ifdef CONFIG_BUTTON_STATS
+	button_stats_init(me);
+#endif /* CONFIG_BUTTON_STATS */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Creater FreeRTOS software timer to filter button bounce */
+	if (buffers != NULL) {
+		me->debounce_timer = xTimerCreateStatic("Debounce timer",
+				me->debounce_ticks,
+				pdFALSE,
+				(void *)me,
+				debounce_timer_handler,
+				&buffers->debounce_timer);
+	}
+#if configSUPPORT_DYNAMIC_ALLOCATION
+	else {
+		me->debounce_timer = xTimerCreate("Debounce timer",
+				me->debounce_ticks,
+				pdFALSE,
+				(void *)me,
+				debounce_timer_handler);
+	}
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+	if (me->debounce_timer == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate memory to timer");
+		button_teardown(me);
+		return ESP_ERR_NO_MEM;
+	}
+
+	/* Creater FreeRTOS software timer to count the clicks number */
+	if (buffers != NULL) {
+		me->click_timer = xTimerCreateStatic("Click timer",
+				me->click_ticks,
+				pdFALSE,
+				(void *)me,
+				click_timer_handler,
+				&buffers->click_timer);
+	}
+#if configSUPPORT_DYNAMIC_ALLOCATION
+	else {
+		me->click_timer = xTimerCreate("Click timer",
+				me->click_ticks,
+				pdFALSE,
+				(void *)me,
+				click_timer_handler);
+	}
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+	if (me->click_timer == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate memory to timer");
+		button_teardown(me);
+		return ESP_ERR_NO_MEM;
+	}
+#elif defined(CONFIG_BUTTON_GROUP)
+	me->grouped = false;
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifdef CONFIG_BUTTON_REGISTRY
+	/* Register the button in the button service and the scan engine */
+	ret = button_register(me);
+
+	if (ret != ESP_OK) {
+		button_teardown(me);
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_REGISTRY */
+
+#ifdef CONFIG_BUTTON_WAKEUP
+	/* Set the button pin as wakeup source */
+	ret = button_wakeup_init(me);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to enable button wakeup");
+		button_teardown(me);
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+	/* Handle the press that woke up the chip before the ISR can see it */
+	button_wakeup_replay(me);
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Add ISR handler */
+	ret = gpio_isr_handler_add(me->gpio, isr_handler, (void *)me);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to add GPIO ISR handler");
+		button_teardown(me);
+		return ret;
+	}
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	/* Create RTOS task */
+	me->task_static = buffers != NULL;
+
+	if (buffers != NULL) {
+		me->ring.task = xTaskCreateStaticPinnedToCore(button_task,
+				CONFIG_BUTTON_TASK_NAME,
+				task_stack_size,
+				(void *)me,
+				task_priority,
+				buffers->task_stack,
+				&buffers->task,
+				BUTTON_TASK_CORE);
+	}
+#if configSUPPORT_DYNAMIC_ALLOCATION
+	else {
+		xTaskCreatePinnedToCore(button_task,
+				CONFIG_BUTTON_TASK_NAME,
+				task_stack_size,
+				(void *)me,
+				task_priority,
+				&me->ring.task,
+				BUTTON_TASK_CORE);
+	}
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+	if (me->ring.task == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate memory to create task");
+		button_teardown(me);
+		return ESP_ERR_NO_MEM;
+	}
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+static void button_teardown(button_t *const me) {
+#ifdef CONFIG_BUTTON_REGISTRY
+	/* Stop scanning and dispatching the button */
+	button_unregister(me);
+#endif /* CONFIG_BUTTON_REGISTRY */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* Detach the ISR, no edge starts a timer after this point */
+	gpio_set_intr_type(me->gpio, GPIO_INTR_DISABLE);
+	gpio_isr_handler_remove(me->gpio);
+
+	/* The timer callbacks running now end before the sync, the next ones find
+	 * no button */
+	if (me->debounce_timer != NULL) {
+		vTimerSetTimerID(me->debounce_timer, NULL);
+	}
+
+	if (me->click_timer != NULL) {
+		vTimerSetTimerID(me->click_timer, NULL);
+	}
+
+	button_timer_call(NULL, NULL);
+
+	/* Delete the timers after the commands posted by those callbacks */
+	if (me->debounce_timer != NULL) {
+		xTimerDelete(me->debounce_timer, portMAX_DELAY);
+	}
+
+	if (me->click_timer != NULL) {
+		xTimerDelete(me->click_timer, portMAX_DELAY);
+	}
+
+	button_timer_call(NULL, NULL);
+
+	me->debounce_timer = NULL;
+	me->click_timer = NULL;
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifdef CONFIG_BUTTON_WAKEUP
+	button_wakeup_deinit(me);
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	if (me->ring.task != NULL) {
+		/* The task drains the ring and acknowledges outside of any callback */
+		StaticSemaphore_t stop_buffer;
+		SemaphoreHandle_t stop = xSemaphoreCreateBinaryStatic(&stop_buffer);
+
+		__atomic_store_n(&me->ring.stop, stop, __ATOMIC_RELEASE);
+		xTaskNotifyGive(me->ring.task);
+		xSemaphoreTake(stop, portMAX_DELAY);
+		vSemaphoreDelete(stop);
+
+		/* A static task only suspends itself after the acknowledge. Once it is
+		 * not running it is deleted at once, its buffers are free on return */
+		if (me->task_static) {
+			while (eTaskGetState(me->ring.task) != eSuspended) {
+				vTaskDelay(1);
+			}
+
+			vTaskDelete(me->ring.task);
+		}
+
+		me->ring.task = NULL;
+	}
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+	if (me->glitch_filter != NULL) {
+		gpio_glitch_filter_disable(me->glitch_filter);
+		gpio_del_glitch_filter(me->glitch_filter);
+		me->glitch_filter = NULL;
+	}
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+	/* Release the button GPIO */
+	gpio_reset_pin(me->gpio);
+}
+
+static esp_err_t button_config_apply(button_t *const me,
+		const button_config_t *const config) {
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	/* The debounce timer filters the bounces, every edge is a sample */
+	esp_err_t ret = button_config_to_core(config, 0, &me->config);
+#else
+	esp_err_t ret = button_config_to_core(config, CONFIG_BUTTON_SCAN_PERIOD,
+			&me->config);
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	me->debounce_ticks = BUTTON_TIMER_TICKS(config->debounce_time);
+	me->click_ticks = BUTTON_TIMER_TICKS(config->click_time);
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+	/* The configured debounce time is the first estimate, within the bounds */
+	me->edge_time = 0;
+	me->bounce_time = 0;
+	me->bounce_peak = 0;
+	me->bounce_quiet = 0;
+	me->bounce_estimate = me->config.short_time * 2 / 3;
+	button_debounce_adapt(me, me->bounce_estimate);
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+/*
+ * All the ISR state lives in the button instance. While the interrupt of a
+ * button is enabled only its ISR writes the press time and the state, and
+ * while it is disabled only its debounce timer does, so edges on different
+ * buttons, on any core, never share data. The click counter is the only field
+ * shared with the click timer and it is updated with atomic operations, so no
+ * critical section is needed.
+ */
+static void isr_handler(void *arg) {
+	button_t *button = (button_t *)arg;
+
+#ifdef CONFIG_BUTTON_WAKEUP
+	/* Drop the level latched before the wakeup replay disabled the interrupt */
+	if (!__atomic_exchange_n(&button->armed, false, __ATOMIC_RELAXED)) {
+		return;
+	}
+#elif defined(CONFIG_BUTTON_ISR_ANYEDGE)
+	/* Drop the bounces, the edges until the debounce timer arms the button */
+	if (!__atomic_exchange_n(&button->armed, false, __ATOMIC_RELAXED)) {
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+		/* The last bounce dropped ends the bounce time of the edge */
+		button->bounce_time = (button_core_time_t)BUTTON_GET_TIME_FROM_ISR();
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+		return;
+	}
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+	button_edge_from_isr(button, BUTTON_GET_TIME_FROM_ISR());
+
+	portYIELD_FROM_ISR();
+}
+
+static void button_edge_from_isr(button_t *const me, button_time_t now) {
+#ifndef CONFIG_BUTTON_ISR_ANYEDGE
+	/* Disable button interrupt */
+	gpio_set_intr_type(me->gpio, GPIO_INTR_DISABLE);
+#endif /* CONFIG_BUTTON_ISR_ANYEDGE */
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+	/* Measure the bounces from this edge */
+	me->edge_time = (button_core_time_t)now;
+	me->bounce_time = (button_core_time_t)now;
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+
+#if defined(CONFIG_BUTTON_TRACE) || defined(CONFIG_BUTTON_COMBO)
+	/* A press edge while released, a release edge otherwise */
+	bool pressed = !me->core.pressed;
+#endif /* CONFIG_BUTTON_TRACE || CONFIG_BUTTON_COMBO */
+
+	/* Classify the edge, a release ends the press */
+	button_core_event_t event = button_core_edge(&me->core, &me->config, now);
+
+#ifdef CONFIG_BUTTON_COMBO
+	button_combo_post(me, !pressed, now);
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_TRACE
+	button_trace(me, pressed, event, now);
+#endif /* CONFIG_BUTTON_TRACE */
+
+	BUTTON_ISR_LOGD("button %d edge %d", me->gpio, event);
+
+	if (event == BUTTON_CORE_CLICK) {
+		/* Start click timer, its period can be changed by a repeat */
+		xTimerChangePeriodFromISR(me->click_timer, me->click_ticks, NULL);
+	}
+	else if (BUTTON_CORE_IS_CLICK(event)) {
+		button_post_event(me, (button_click_e)event,
+				button_core_count(&me->core, event), now, true);
+	}
+	else if (event == BUTTON_CORE_BOUNCE) {
+		BUTTON_ISR_LOGD("button %d bounce", me->gpio);
+#ifdef CONFIG_BUTTON_STATS
+		__atomic_fetch_add(&me->stats.bounces, 1, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_STATS */
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+		/* The switch still bounced after the debounce time of the press */
+		button_debounce_adapt(me, (button_core_time_t)now - me->core.press_time);
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+	}
+
+	/* Start debounce timer, also after a bounce to enable the interrupt again */
+	xTimerChangePeriodFromISR(me->debounce_timer, me->debounce_ticks, NULL);
+}
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifndef CONFIG_BUTTON_DISPATCH_PULL
+static void button_task(void *arg) {
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	button_t *button = (button_t *)arg;
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+	button_ring_t *ring = BUTTON_RING(button);
+	button_event_t event;
+#if CONFIG_BUTTON_LOG_LEVEL >= 2
+	uint32_t dropped = 0;
+#endif /* CONFIG_BUTTON_LOG_LEVEL >= 2 */
+
+	for (;;) {
+		/* Drain all the pending events */
+		while (ring_pop(ring, &event)) {
+#ifdef CONFIG_BUTTON_COMBO
+			/* Track the button states up to the event and drop the clicks of a
+			 * fired combination */
+			button_combo_replay(event.timestamp);
+
+			if (event.id < BUTTON_COMBO_IDS &&
+					(__atomic_load_n(&combo_suppressed, __ATOMIC_RELAXED) &
+					(1ULL << event.id))) {
+				/* The next events of the click type post a new event */
+				button_t *target = event.click < BUTTON_CLICK_MAX ?
+						button_lookup(&event) : NULL;
+
+				if (target != NULL) {
+					__atomic_store_n(&target->pending[event.click], 0, __ATOMIC_RELAXED);
+				}
+
+				continue;
+			}
+#endif /* CONFIG_BUTTON_COMBO */
+
+			if (event.click >= BUTTON_CLICK_MAX) {
+				BUTTON_LOGW("Button unexpected event");
+				continue;
+			}
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+			button_dispatch(button, (button_click_e)event.click, event.count,
+					event.timestamp);
+#else
+			/* Publish the button before checking it is still registered, so
+			 * button_deinit() waits until its callbacks return */
+			button_t *target = button_lookup(&event);
+
+			__atomic_store_n(&dispatching, target, __ATOMIC_SEQ_CST);
+
+			if (target != NULL &&
+					__atomic_load_n(&buttons[event.id], __ATOMIC_SEQ_CST) == target) {
+				button_dispatch(target, (button_click_e)event.click, event.count,
+						event.timestamp);
+			}
+
+			__atomic_store_n(&dispatching, NULL, __ATOMIC_RELEASE);
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+		}
+
+#ifdef CONFIG_BUTTON_COMBO
+		/* Track the state changes posted after the last click */
+		button_combo_replay(INT64_MAX);
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+		/* Stop for button_deinit() once the posted events are dispatched, the
+		 * button can be freed as soon as the request is acknowledged */
+		SemaphoreHandle_t stop = __atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE);
+
+		if (stop != NULL) {
+			bool task_static = button->task_static;
+
+			xSemaphoreGive(stop);
+
+			/* The buffers of a static task stay in use until the idle task cleans
+			 * up after a self deletion, button_deinit() deletes it instead */
+			if (task_static) {
+				vTaskSuspend(NULL);
+			}
+
+			vTaskDelete(NULL);
+		}
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+
+#if CONFIG_BUTTON_LOG_LEVEL >= 2
+		/* Report the events lost with the ring full */
+		if (__atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) != dropped) {
+			dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+			BUTTON_LOGW("%lu button events dropped", (unsigned long)dropped);
+		}
+#endif /* CONFIG_BUTTON_LOG_LEVEL >= 2 */
+
+		/* Wait until some event is posted */
+#ifdef CONFIG_BUTTON_COMBO
+		ulTaskNotifyTake(pdTRUE, button_combo_tick());
+#else
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif /* CONFIG_BUTTON_COMBO */
+	}
+}
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+#ifdef CONFIG_BUTTON_REGISTRY
+static esp_err_t button_register(button_t *const me) {
+	/* Reuse the slot of a deinitialized button before adding a new one */
+	uint8_t id = 0;
+
+	while (id < buttons_num && buttons[id] != NULL) {
+		id++;
+	}
+
+	if (id >= CONFIG_BUTTON_MAX_BUTTONS) {
+		ESP_LOGE(TAG, "Button registry is full");
+		return ESP_ERR_NO_MEM;
+	}
+
+#ifdef CONFIG_BUTTON_TASK_MODE_SERVICE
+	/* Create the service ring and task on first registration */
+	if (service_ring.slots == NULL) {
+		ring_init(&service_ring, service_ring_slots,
+				CONFIG_BUTTON_SERVICE_QUEUE_SIZE);
+#ifdef CONFIG_BUTTON_COMBO
+		ring_init(&combo_ring, combo_ring_slots, CONFIG_BUTTON_COMBO_QUEUE_SIZE);
+		combo_held = false;
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifndef CONFIG_BUTTON_DISPATCH_PULL
+		service_ring.task = xTaskCreateStaticPinnedToCore(button_task,
+				CONFIG_BUTTON_SERVICE_TASK_NAME,
+				CONFIG_BUTTON_SERVICE_TASK_STACK_SIZE,
+				NULL,
+				CONFIG_BUTTON_SERVICE_TASK_PRIORITY,
+				service_task_stack,
+				&service_task_buffer,
+				BUTTON_TASK_CORE);
+
+		if (service_ring.task == NULL) {
+			ESP_LOGE(TAG, "Failed to create task");
+			service_ring.slots = NULL;
+			return ESP_FAIL;
+		}
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+	}
+#endif /* CONFIG_BUTTON_TASK_MODE_SERVICE */
+
+#ifdef CONFIG_BUTTON_ENGINE_SCAN
+	/* Create and start the scan timer on first registration */
+	if (scan_timer == NULL) {
+		const esp_timer_create_args_t timer_args = {
+				.callback = scan_timer_handler,
+				.arg = NULL,
+				.dispatch_method = ESP_TIMER_TASK,
+				.name = "Button scan",
+				.skip_unhandled_events = true
+		};
+
+		esp_err_t ret = esp_timer_create(&timer_args, &scan_timer);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to create scan timer");
+			return ret;
+		}
+
+		ret = esp_timer_start_periodic(scan_timer,
+				CONFIG_BUTTON_SCAN_PERIOD * 1000);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to start scan timer");
+			return ret;
+		}
+	}
+#endif /* CONFIG_BUTTON_ENGINE_SCAN */
+
+	/* Add the button to the registry, the scan timer can read it at any time */
+	me->id = id;
+	me->generation = ++generations[id];
+	__atomic_store_n(&buttons[id], me, __ATOMIC_RELEASE);
+
+	if (id == buttons_num) {
+		__atomic_store_n(&buttons_num, buttons_num + 1, __ATOMIC_RELEASE);
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+static void button_unregister(button_t *const me) {
+	/* Nothing to do for a button that failed to register */
+	if (me->id >= CONFIG_BUTTON_MAX_BUTTONS || buttons[me->id] != me) {
+		return;
+	}
+
+	/* Free the slot, the events of the button still in the ring are dropped */
+	__atomic_store_n(&buttons[me->id], NULL, __ATOMIC_SEQ_CST);
+
+#ifdef CONFIG_BUTTON_COMBO
+	/* The next button of the slot is not part of its combinations */
+	button_combo_drop(me->id);
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_ENGINE_SCAN
+	/* Wait until the scan running now, if any, ends */
+	uint32_t passes = __atomic_load_n(&scan_passes, __ATOMIC_ACQUIRE);
+
+	while (__atomic_load_n(&scan_passes, __ATOMIC_ACQUIRE) == passes) {
+		vTaskDelay(1);
+	}
+#endif /* CONFIG_BUTTON_ENGINE_SCAN */
+
+#ifdef CONFIG_BUTTON_TASK_MODE_SERVICE
+	/* Wait until the callbacks of the button running now return */
+	while (__atomic_load_n(&dispatching, __ATOMIC_SEQ_CST) == me) {
+		vTaskDelay(1);
+	}
+#endif /* CONFIG_BUTTON_TASK_MODE_SERVICE */
+}
+
+#ifdef CONFIG_BUTTON_TASK_MODE_SERVICE
+static button_t *button_lookup(const button_event_t *event) {
+	button_t *button = event->id < buttons_num ?
+			__atomic_load_n(&buttons[event->id], __ATOMIC_SEQ_CST) : NULL;
+
+	/* The index can belong to a button registered after the event was posted */
+	if (button == NULL || button->generation != event->generation) {
+		return NULL;
+	}
+
+	return button;
+}
+#endif /* CONFIG_BUTTON_TASK_MODE_SERVICE */
+#endif /* CONFIG_BUTTON_REGISTRY */
+
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+static esp_err_t button_glitch_filter_init(button_t *const me) {
+	esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+#if SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+	gpio_flex_glitch_filter_config_t flex_conf = {
+			.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+			.gpio_num = me->gpio,
+			.window_width_ns = CONFIG_BUTTON_GLITCH_FILTER_WINDOW_NS,
+			.window_thres_ns = CONFIG_BUTTON_GLITCH_FILTER_WINDOW_NS
+	};
+
+	ret = gpio_new_flex_glitch_filter(&flex_conf, &me->glitch_filter);
+#endif /* SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0 */
+
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+	/* Use the pin filter when no flex filter is left or the window is invalid */
+	if (ret != ESP_OK) {
+		gpio_pin_glitch_filter_config_t pin_conf = {
+				.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+				.gpio_num = me->gpio
+		};
+
+		ret = gpio_new_pin_glitch_filter(&pin_conf, &me->glitch_filter);
+	}
+#endif /* SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER */
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+	return gpio_glitch_filter_enable(me->glitch_filter);
+}
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+static void ring_init(button_ring_t *const ring, button_ring_slot_t *slots,
+		uint32_t size) {
+	ring->slots = slots;
+	ring->mask = size - 1;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+	ring->task = NULL;
+	ring->stop = NULL;
+
+	/* Every slot starts free for the position with its same index */
+	for (uint32_t i = 0; i < size; i++) {
+		ring->slots[i].seq = i;
+	}
+}
+
+static bool ring_push(button_ring_t *const ring,
+		const button_event_t *event) {
+	button_ring_slot_t *slot;
+	uint32_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+	/* Reserve a slot, several producers can race for the same position */
+	for (;;) {
+		slot = &ring->slots[pos & ring->mask];
+		int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			/* Ring full */
+			__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		else {
+			pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	/* Write the event and publish the slot to the consumer */
+	slot->event = *event;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+static bool ring_pop(button_ring_t *const ring, button_event_t *event) {
+	button_ring_slot_t *slot = &ring->slots[ring->head & ring->mask];
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring->head + 1) {
+		/* Ring empty */
+		return false;
+	}
+
+	/* Read the event and release the slot for the next lap */
+	*event = slot->event;
+	__atomic_store_n(&slot->seq, ring->head + ring->mask + 1, __ATOMIC_RELEASE);
+	ring->head++;
+
+	return true;
+}
+
+static void button_post_event(button_t *const me, button_click_e click_type,
+		uint8_t count, button_time_t timestamp, bool from_isr) {
+	button_ring_t *ring = BUTTON_RING(me);
+
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+	button_isr_dispatch(me, click_type);
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+
+	/* Do not wake up the button task without a callback to execute */
+	if (!(__atomic_load_n(&me->click_mask, __ATOMIC_RELAXED) & (1 << click_type))) {
+		return;
+	}
+
+	/* Merge the event into the one of the same type not dispatched yet, the
+	 * count saturates so that it never wraps back to 0 while one is queued */
+	uint8_t pending = __atomic_load_n(&me->pending[click_type], __ATOMIC_RELAXED);
+	while (pending != UINT8_MAX && !__atomic_compare_exchange_n(
+			&me->pending[click_type], &pending, pending + 1, true,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+	}
+	if (pending != 0) {
+#ifdef CONFIG_BUTTON_STATS
+		__atomic_fetch_add(&me->stats.coalesced, 1, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_STATS */
+		return;
+	}
+
+	button_event_t event = {
+			.id = BUTTON_ID(me),
+			.click = (uint8_t)click_type,
+			.count = count,
+			.generation = BUTTON_GENERATION(me),
+			.timestamp = timestamp
+	};
+
+	if (!ring_push(ring, &event)) {
+		__atomic_store_n(&me->pending[click_type], 0, __ATOMIC_RELAXED);
+#ifdef CONFIG_BUTTON_STATS
+		__atomic_fetch_add(&me->stats.dropped, 1, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_STATS */
+		return;
+	}
+
+	if (ring->task == NULL) {
+		return;
+	}
+
+	if (from_isr) {
+		vTaskNotifyGiveFromISR(ring->task, NULL);
+	}
+	else {
+		xTaskNotifyGive(ring->task);
+	}
+}
+
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+static void button_isr_dispatch(button_t *const me, button_click_e click_type) {
+	button_cb_t function = __atomic_load_n(&me->isr_function[click_type].function,
+			__ATOMIC_ACQUIRE);
+	void *arg = me->isr_function[click_type].arg;
+
+	/* Skip a callback replaced while its argument was read */
+	if (function != NULL && function == __atomic_load_n(
+			&me->isr_function[click_type].function, __ATOMIC_SEQ_CST)) {
+		function(arg);
+	}
+}
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+static bool button_pull(button_pull_event_t *const record) {
+	button_event_t event;
+
+	/* Nothing is posted before the first button is registered */
+	if (service_ring.slots == NULL) {
+		return false;
+	}
+
+	/* Skip the events of the deinitialized buttons */
+	while (ring_pop(&service_ring, &event)) {
+		if (event.click >= BUTTON_CLICK_MAX) {
+			BUTTON_LOGW("Button unexpected event");
+			continue;
+		}
+
+		/* Publish the button before checking it is still registered, so
+		 * button_deinit() waits until the event is read */
+		button_t *target = button_lookup(&event);
+
+		__atomic_store_n(&dispatching, target, __ATOMIC_SEQ_CST);
+
+		bool registered = target != NULL &&
+				__atomic_load_n(&buttons[event.id], __ATOMIC_SEQ_CST) == target;
+
+		if (registered) {
+			/* Take the events merged until now, the next ones post a new event */
+			record->button = target;
+			record->click = event.click;
+			record->count = event.count;
+			record->events = __atomic_exchange_n(&target->pending[event.click], 0,
+					__ATOMIC_RELAXED);
+			record->timestamp = event.timestamp;
+
+#ifdef CONFIG_BUTTON_STATS
+			/* The latency is measured up to the read, there is no callback */
+			button_click_stats_t *stats = &target->stats.click[event.click];
+			uint32_t latency = (uint32_t)(BUTTON_GET_TIME() - event.timestamp);
+
+			stats->count++;
+			stats->latency_min = latency < stats->latency_min ? latency : stats->latency_min;
+			stats->latency_max = latency > stats->latency_max ? latency : stats->latency_max;
+			stats->duration_min = 0;
+			target->latency_sum[event.click] += latency;
+#endif /* CONFIG_BUTTON_STATS */
+		}
+
+		__atomic_store_n(&dispatching, NULL, __ATOMIC_RELEASE);
+
+		if (registered) {
+			return true;
+		}
+	}
+
+	return false;
+}
+#else
+static void button_dispatch(button_t *const me, button_click_e click_type,
+		uint8_t count, button_time_t timestamp) {
+	/* Take the events merged until now, the next ones post a new event */
+	me->event_count = __atomic_exchange_n(&me->pending[click_type], 0,
+			__ATOMIC_RELAXED);
+	me->click_count = count;
+
+	BUTTON_LOGI("Button %d click %d x%d", me->gpio, click_type, me->event_count);
+
+	/* Copy the callbacks, they can be edited while they are executed */
+	button_function_t table[CONFIG_BUTTON_MAX_CALLBACKS];
+	uint8_t num = button_callbacks_copy(&me->callbacks, click_type, table);
+
+	if (num > 0) {
+#ifdef CONFIG_BUTTON_STATS
+		button_time_t start = BUTTON_GET_TIME();
+#endif /* CONFIG_BUTTON_STATS */
+
+		/* Execute callback functions */
+		for (uint8_t i = 0; i < num; i++) {
+			button_execute(me, &table[i], click_type, count, timestamp);
+		}
+
+#ifdef CONFIG_BUTTON_STATS
+		button_click_stats_t *stats = &me->stats.click[click_type];
+		uint32_t latency = (uint32_t)(start - timestamp);
+		uint32_t duration = (uint32_t)(BUTTON_GET_TIME() - start);
+
+		stats->count++;
+		stats->latency_min = latency < stats->latency_min ? latency : stats->latency_min;
+		stats->latency_max = latency > stats->latency_max ? latency : stats->latency_max;
+		stats->duration_min = duration < stats->duration_min ? duration : stats->duration_min;
+		stats->duration_max = duration > stats->duration_max ? duration : stats->duration_max;
+		me->latency_sum[click_type] += latency;
+		me->duration_sum[click_type] += duration;
+#endif /* CONFIG_BUTTON_STATS */
+	}
+	else {
+		BUTTON_LOGW("Function callback not added");
+	}
+}
+
+static void button_execute(button_t *const me,
+		const button_function_t *function, button_click_e click_type,
+		uint8_t count, button_time_t timestamp) {
+#ifdef CONFIG_BUTTON_DISPATCH_INLINE
+	function->function(function->arg);
+#else
+	button_work_t work = {
+			.button = me,
+			.function = *function,
+			.click = (uint8_t)click_type,
+			.count = count,
+			.events = me->event_count,
+			.timestamp = timestamp
+	};
+
+#ifdef CONFIG_BUTTON_DISPATCH_EXECUTOR
+	button_executor_t executor_function = __atomic_load_n(&executor,
+			__ATOMIC_ACQUIRE);
+
+	/* Without executor the callback runs here */
+	if (executor_function == NULL) {
+		function->function(function->arg);
+		return;
+	}
+
+	bool posted = executor_function(&work, executor_arg);
+#else
+	/* Never wait for the event loop, the next events would wait too */
+	bool posted = esp_event_post(BUTTON_EVENT, click_type, &work, sizeof(work),
+			0) == ESP_OK;
+#endif /* CONFIG_BUTTON_DISPATCH_EXECUTOR */
+
+	if (!posted) {
+#ifdef CONFIG_BUTTON_STATS
+		__atomic_fetch_add(&me->stats.dropped, 1, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_STATS */
+		BUTTON_LOGW("Button %d callback dropped", me->gpio);
+	}
+#endif /* CONFIG_BUTTON_DISPATCH_INLINE */
+}
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+static esp_err_t button_event_handler_init(void) {
+	if (event_handler_registered) {
+		return ESP_OK;
+	}
+
+	esp_err_t ret = esp_event_handler_register(BUTTON_EVENT, ESP_EVENT_ANY_ID,
+			button_event_handler, NULL);
+
+	if (ret == ESP_OK) {
+		event_handler_registered = true;
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+static void button_event_handler(void *arg, esp_event_base_t base, int32_t id,
+		void *data) {
+	button_work_run((const button_work_t *)data);
+}
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+
+#ifdef CONFIG_BUTTON_STATS
+static void button_stats_init(button_t *const me) {
+	memset(&me->stats, 0, sizeof(me->stats));
+
+	for (uint8_t i = 0; i < BUTTON_CLICK_MAX; i++) {
+		me->stats.click[i].latency_min = UINT32_MAX;
+		me->stats.click[i].duration_min = UINT32_MAX;
+		me->latency_sum[i] = 0;
+		me->duration_sum[i] = 0;
+	}
+}
+#endif /* CONFIG_BUTTON_STATS */
+
+#ifdef CONFIG_BUTTON_COMBO
+static esp_err_t button_combo_add(button_t *const *members, uint8_t num,
+		bool sequence, uint32_t time, bool suppress, button_cb_t function,
+		void *arg) {
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+	/* Check arguments */
+	if (members == NULL || function == NULL || num < 2 ||
+			num > CONFIG_BUTTON_COMBO_MAX_LENGTH || time > BUTTON_TIME_MAX) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	button_combo_t combo = {
+			.mask = 0,
+			.num = num,
+			.sequence = sequence,
+			.suppress = suppress,
+			.fired = false,
+			.step = 0,
+			.time = (button_time_t)time * 1000,
+			.start = -1,
+			.function = {.function = function, .arg = arg}
+	};
+
+	for (uint8_t i = 0; i < num; i++) {
+		button_t *button = members[i];
+
+		/* Only registered buttons have an id */
+		if (button == NULL || button->id >= BUTTON_COMBO_IDS ||
+				__atomic_load_n(&buttons[button->id], __ATOMIC_RELAXED) !=
+				button) {
+			ESP_LOGE(TAG, "Invalid combination button");
+			return ESP_ERR_INVALID_ARG;
+		}
+
+		/* A chord has each button once, a sequence can repeat them */
+		if (!sequence && (combo.mask & (1ULL << button->id))) {
+			ESP_LOGE(TAG, "Repeated chord button");
+			return ESP_ERR_INVALID_ARG;
+		}
+
+		combo.mask |= 1ULL << button->id;
+		combo.ids[i] = button->id;
+	}
+
+	portENTER_CRITICAL(&function_lock);
+
+	if (combos_num < CONFIG_BUTTON_MAX_COMBOS) {
+		combos[combos_num++] = combo;
+	}
+	else {
+		ret = ESP_ERR_NO_MEM;
+	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Combination table is full");
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+static void button_combo_post(button_t *const me, bool was_pressed,
+		button_time_t now) {
+	/* Only the state changes matter, and only with combinations */
+	if (me->core.pressed == was_pressed || me->id >= BUTTON_COMBO_IDS ||
+			__atomic_load_n(&combos_num, __ATOMIC_RELAXED) == 0) {
+		return;
+	}
+
+	button_event_t event = {
+			.id = me->id,
+			.click = me->core.pressed ? BUTTON_EVENT_PRESS : BUTTON_EVENT_RELEASE,
+			.count = 0,
+			.generation = me->generation,
+			.timestamp = now
+	};
+
+	if (!ring_push(&combo_ring, &event)) {
+#ifdef CONFIG_BUTTON_STATS
+		__atomic_fetch_add(&me->stats.dropped, 1, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_STATS */
+		return;
+	}
+
+	/* Also called from the timer task, the notification is ISR safe */
+	if (service_ring.task != NULL) {
+		vTaskNotifyGiveFromISR(service_ring.task, NULL);
+	}
+}
+
+static void button_combo_update(uint8_t id, bool pressed,
+		button_time_t timestamp) {
+	uint64_t bit = 1ULL << id;
+	button_function_t fired[CONFIG_BUTTON_MAX_COMBOS];
+	uint8_t fired_num = 0;
+
+	/* Match the combinations of the button, the callbacks run unlocked */
+	portENTER_CRITICAL(&function_lock);
+
+	if (pressed) {
+		combo_pressed |= bit;
+		__atomic_fetch_and(&combo_suppressed, ~bit, __ATOMIC_RELAXED);
+	}
+	else {
+		combo_pressed &= ~bit;
+	}
+
+	for (uint8_t i = 0; i < combos_num; i++) {
+		button_combo_t *combo = &combos[i];
+
+		if (!(combo->mask & bit)) {
+			continue;
+		}
+
+		if (!combo->sequence) {
+			/* A release breaks the chord, the last press completes it */
+			if (!pressed) {
+				combo->fired = false;
+				combo->start = -1;
+			}
+			else if ((combo_pressed & combo->mask) == combo->mask) {
+				combo->start = timestamp;
+				combo->fired = combo->time == 0;
+			}
+			else {
+				continue;
+			}
+		}
+		else if (pressed) {
+			/* The next press of the sequence within the window */
+			if (combo->ids[combo->step] == id && (combo->step == 0 ||
+					timestamp - combo->start <= combo->time)) {
+				combo->step++;
+			}
+			else {
+				combo->step = combo->ids[0] == id ? 1 : 0;
+			}
+
+			combo->start = timestamp;
+			combo->fired = combo->step == combo->num;
+
+			if (combo->fired) {
+				combo->step = 0;
+			}
+		}
+		else {
+			continue;
+		}
+
+		if (combo->fired && pressed) {
+			fired[fired_num++] = combo->function;
+
+			if (combo->suppress) {
+				__atomic_fetch_or(&combo_suppressed, combo->mask, __ATOMIC_RELAXED);
+			}
+		}
+	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	for (uint8_t i = 0; i < fired_num; i++) {
+		fired[i].function(fired[i].arg);
+	}
+}
+
+static void button_combo_replay(button_time_t until) {
+	/* Keep the first state change after the time for the next click */
+	while (combo_held || ring_pop(&combo_ring, &combo_event)) {
+		if (combo_event.timestamp > until) {
+			combo_held = true;
+			return;
+		}
+
+		combo_held = false;
+
+		if (button_lookup(&combo_event) != NULL) {
+			button_combo_update(combo_event.id,
+					combo_event.click == BUTTON_EVENT_PRESS, combo_event.timestamp);
+		}
+	}
+}
+
+static TickType_t button_combo_tick(void) {
+	button_function_t fired[CONFIG_BUTTON_MAX_COMBOS];
+	uint8_t fired_num = 0;
+	button_time_t now = BUTTON_GET_TIME();
+	button_time_t next = -1;
+
+	/* Fire the chords held for their hold time */
+	portENTER_CRITICAL(&function_lock);
+
+	for (uint8_t i = 0; i < combos_num; i++) {
+		button_combo_t *combo = &combos[i];
+
+		if (combo->sequence || combo->fired || combo->start < 0) {
+			continue;
+		}
+
+		button_time_t left = combo->start + combo->time - now;
+
+		if (left <= 0) {
+			combo->fired = true;
+			fired[fired_num++] = combo->function;
+
+			if (combo->suppress) {
+				__atomic_fetch_or(&combo_suppressed, combo->mask, __ATOMIC_RELAXED);
+			}
+		}
+		else if (next < 0 || left < next) {
+			next = left;
+		}
+	}
+
+	portEXIT_CRITICAL(&function_lock);
+
+	for (uint8_t i = 0; i < fired_num; i++) {
+		fired[i].function(fired[i].arg);
+	}
+
+	/* Wait for the next event or the next chord hold time */
+	return next < 0 ? portMAX_DELAY : BUTTON_TIMER_TICKS_US(next);
+}
+
+static void button_combo_drop(uint8_t id) {
+	uint64_t bit = id < BUTTON_COMBO_IDS ? 1ULL << id : 0;
+
+	portENTER_CRITICAL(&function_lock);
+
+	for (uint8_t i = 0; i < combos_num;) {
+		if (combos[i].mask & bit) {
+			combos[i] = combos[--combos_num];
+		}
+		else {
+			i++;
+		}
+	}
+
+	combo_pressed &= ~bit;
+	__atomic_fetch_and(&combo_suppressed, ~bit, __ATOMIC_RELAXED);
+	portEXIT_CRITICAL(&function_lock);
+}
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_TRACE
+static inline void IRAM_ATTR button_trace(const button_t *const me,
+		bool pressed, button_core_event_t event, button_time_t now) {
+	/* Claim a slot, the sequence number is written last to commit it */
+	uint32_t seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+	button_trace_record_t *record =
+			&trace_ring[seq & (CONFIG_BUTTON_TRACE_SIZE - 1)];
+
+	record->timestamp = (uint32_t)now;
+	record->gpio = me->gpio;
+	record->level = pressed == (BUTTON_ACTIVE_LEVEL(me) != 0);
+	record->event = event;
+	__atomic_store_n(&record->seq, (uint8_t)seq, __ATOMIC_RELEASE);
+}
+#endif /* CONFIG_BUTTON_TRACE */
+
+#ifdef CONFIG_BUTTON_FOOTPRINT_REPORT
+static void button_footprint_report(uint32_t task_stack_size) {
+	static bool reported = false;
+
+	if (reported) {
+		return;
+	}
+
+	reported = true;
+
+	/* RAM of one button, the instance and what is allocated for it */
+	ESP_LOGI(TAG, "Button RAM: %u bytes per instance, %u bytes of classifier "
+			"state", (unsigned)sizeof(button_t), (unsigned)sizeof(button_core_t));
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	ESP_LOGI(TAG, "Button RAM: %u bytes per button of software timers",
+			(unsigned)(2 * sizeof(StaticTimer_t)));
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	ESP_LOGI(TAG, "Button RAM: %lu bytes per button of task",
+			(unsigned long)(task_stack_size + sizeof(StaticTask_t)));
+#elif !defined(CONFIG_BUTTON_DISPATCH_PULL)
+	ESP_LOGI(TAG, "Button RAM: %lu bytes of service task shared by all the "
+			"buttons", (unsigned long)(CONFIG_BUTTON_SERVICE_TASK_STACK_SIZE +
+			sizeof(StaticTask_t)));
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+}
+#endif /* CONFIG_BUTTON_FOOTPRINT_REPORT */
+
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+static void debounce_timer_handler(TimerHandle_t timer) {
+	/* Get instance data */
+	button_t *button = (button_t *)pvTimerGetTimerID(timer);
+
+	/* The button is being deinitialized */
+	if (button == NULL) {
+		return;
+	}
+
+	/* The level after the debounce time is the button state */
+	bool pressed = gpio_get_level(button->gpio) == BUTTON_ACTIVE_LEVEL(button);
+#ifdef CONFIG_BUTTON_COMBO
+	bool was_pressed = button->core.pressed;
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+	/* The press that woke up the chip can end before the boot, it is released
+	 * here once the callbacks are added */
+	if (button->wake_press) {
+		button->wake_press = false;
+
+		if (!pressed) {
+			button_core_settle(&button->core, &button->config, true);
+#ifdef CONFIG_BUTTON_COMBO
+			button_combo_post(button, was_pressed, BUTTON_GET_TIME());
+#endif /* CONFIG_BUTTON_COMBO */
+			button_edge_from_isr(button, BUTTON_GET_TIME());
+			return;
+		}
+	}
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+
+	button_core_settle(&button->core, &button->config, pressed);
+
+#ifdef CONFIG_BUTTON_COMBO
+	button_combo_post(button, was_pressed, BUTTON_GET_TIME());
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+	/* Fit the debounce time to the bounces dropped since the edge, before the
+	 * ISR takes the next edge */
+	button_debounce_adapt(button, button->bounce_time - button->edge_time);
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+
+	/* Enable button interrupt to detect the next edge */
+#if defined(CONFIG_BUTTON_WAKEUP) || defined(CONFIG_BUTTON_ISR_ANYEDGE)
+	__atomic_store_n(&button->armed, true, __ATOMIC_RELAXED);
+#endif /* CONFIG_BUTTON_WAKEUP || CONFIG_BUTTON_ISR_ANYEDGE */
+#ifndef CONFIG_BUTTON_ISR_ANYEDGE
+	gpio_set_intr_type(button->gpio, pressed ? BUTTON_RELEASE_INTR(button) :
+			BUTTON_PRESS_INTR(button));
+#endif /* CONFIG_BUTTON_ISR_ANYEDGE */
+
+	/* Schedule the first repeat of a held press */
+	if (pressed && button->config.repeat_delay > 0) {
+		button_schedule(button, BUTTON_GET_TIME());
+	}
+
+#ifdef CONFIG_BUTTON_ISR_ANYEDGE
+	/* The ISR dropped the edge of a level change after the level was read,
+	 * unless it is handled there once the button is armed */
+	if ((gpio_get_level(button->gpio) == BUTTON_ACTIVE_LEVEL(button)) != pressed &&
+			__atomic_exchange_n(&button->armed, false, __ATOMIC_RELAXED)) {
+		button_edge_from_isr(button, BUTTON_GET_TIME());
+	}
+#endif /* CONFIG_BUTTON_ISR_ANYEDGE */
+}
+
+static void click_timer_handler(TimerHandle_t timer) {
+	/* Get instance data */
+	button_t *button = (button_t *)pvTimerGetTimerID(timer);
+	button_time_t now = BUTTON_GET_TIME();
+	button_core_event_t event;
+
+	/* The button is being deinitialized */
+	if (button == NULL) {
+		return;
+	}
+
+	/* Report the expired click window and the repeats, the ISR can take the
+	 * clicks concurrently */
+	while ((event = button_core_tick(&button->core, &button->config,
+			now + BUTTON_TIMER_SLACK)) != BUTTON_CORE_NONE) {
+		button_post_event(button, (button_click_e)event,
+				button_core_count(&button->core, event), now, false);
+	}
+
+	button_schedule(button, now);
+}
+
+static void button_schedule(button_t *const me, button_time_t now) {
+	button_time_t deadline = button_core_deadline(&me->core, &me->config, now);
+
+	/* Run the click timer again at the next timed gesture */
+	if (deadline >= 0) {
+		xTimerChangePeriod(me->click_timer, BUTTON_TIMER_TICKS_US(deadline), 0);
+	}
+}
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+static void IRAM_ATTR button_debounce_adapt(button_t *const me,
+		button_core_time_t bounce) {
+	/* Keep the debounce time below the medium press time */
+	button_core_time_t max = BUTTON_DEBOUNCE_MAX_US < me->config.medium_time ?
+			BUTTON_DEBOUNCE_MAX_US : me->config.medium_time - 1;
+	bounce = bounce < max ? bounce : max;
+	/* A longer bounce is followed at once. Shorter ones only lower the estimate
+	 * after a run of them, by an eighth of the difference to the longest one of
+	 * the run, so a worn switch that bounces now and then keeps its window */
+	if (bounce > me->bounce_estimate) {
+		me->bounce_estimate = bounce;
+		me->bounce_peak = 0;
+		me->bounce_quiet = 0;
+	}
+	else {
+		me->bounce_peak = bounce > me->bounce_peak ? bounce : me->bounce_peak;
+		if (++me->bounce_quiet >= BUTTON_DEBOUNCE_QUIET) {
+			me->bounce_estimate -= (me->bounce_estimate - me->bounce_peak) >> 3;
+			me->bounce_peak = 0;
+			me->bounce_quiet = 0;
+		}
+	}
+	button_core_time_t time = me->bounce_estimate + me->bounce_estimate / 2;
+
+	time = time > BUTTON_DEBOUNCE_MIN_US ? time : BUTTON_DEBOUNCE_MIN_US;
+
+	/* The bound below the medium press time wins over the minimum */
+	time = time < max ? time : max;
+
+	/* The ISR and the debounce timer do not run at the same time, the ISR
+	 * drops the edges until the timer arms the button */
+	me->config.short_time = time;
+	me->debounce_ticks = (time + BUTTON_TICK_US - 1) / BUTTON_TICK_US;
+}
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+
+static void button_timer_call(void (*function)(void *arg), void *arg) {
+	/* The timer task already runs between two timer callbacks */
+	if (xTaskGetCurrentTaskHandle() == xTimerGetTimerDaemonTaskHandle()) {
+		if (function != NULL) {
+			function(arg);
+		}
+		return;
+	}
+
+	StaticSemaphore_t done_buffer;
+	button_timer_call_t call = {
+			.function = function,
+			.arg = arg,
+			.done = xSemaphoreCreateBinaryStatic(&done_buffer)
+	};
+
+	/* The timer task runs the function after the commands already posted */
+	xTimerPendFunctionCall(button_timer_call_cb, (void *)&call, 0, portMAX_DELAY);
+	xSemaphoreTake(call.done, portMAX_DELAY);
+	vSemaphoreDelete(call.done);
+}
+
+static void button_timer_call_cb(void *arg1, uint32_t arg2) {
+	button_timer_call_t *call = (button_timer_call_t *)arg1;
+
+	if (call->function != NULL) {
+		call->function(call->arg);
+	}
+
+	xSemaphoreGive(call->done);
+}
+
+static void button_config_call(void *arg) {
+	button_config_arg_t *config_arg = (button_config_arg_t *)arg;
+
+	config_arg->ret = button_config_apply(config_arg->button, config_arg->config);
+}
+
+static void button_gestures_call(void *arg) {
+	button_gestures_arg_t *gestures_arg = (button_gestures_arg_t *)arg;
+	button_t *me = gestures_arg->button;
+
+	me->config.max_clicks = gestures_arg->max_clicks;
+	me->config.repeat_delay = gestures_arg->repeat_delay;
+	me->config.repeat_period = gestures_arg->repeat_period;
+}
+
+#else
+static void scan_timer_handler(void *arg) {
+	button_time_t now = BUTTON_GET_TIME();
+	uint8_t num = __atomic_load_n(&buttons_num, __ATOMIC_ACQUIRE);
+
+	/* Step the state machine of every registered button */
+	for (uint8_t i = 0; i < num; i++) {
+		button_t *button = __atomic_load_n(&buttons[i], __ATOMIC_ACQUIRE);
+
+		if (button == NULL) {
+			continue;
+		}
+
+#ifdef CONFIG_BUTTON_GROUP
+		if (button->grouped) {
+			continue;
+		}
+#endif /* CONFIG_BUTTON_GROUP */
+
+		button_scan(button, now);
+	}
+
+#ifdef CONFIG_BUTTON_GROUP
+	/* Step every button group with a single register read each */
+	for (button_group_t *group = __atomic_load_n(&groups, __ATOMIC_ACQUIRE);
+			group != NULL; group = group->next) {
+		button_group_scan(group, now);
+	}
+#endif /* CONFIG_BUTTON_GROUP */
+
+	__atomic_add_fetch(&scan_passes, 1, __ATOMIC_RELEASE);
+}
+
+static void button_scan(button_t *const me, button_time_t now) {
+	bool pressed = gpio_get_level(me->gpio) == BUTTON_ACTIVE_LEVEL(me);
+
+	/* Accept a level change only when it is stable for the debounce time */
+#if defined(CONFIG_BUTTON_TRACE) || defined(CONFIG_BUTTON_COMBO)
+	bool was_pressed = me->core.pressed;
+	button_core_event_t event = button_core_sample(&me->core, &me->config,
+			pressed, now);
+
+#ifdef CONFIG_BUTTON_TRACE
+	/* Trace the accepted level changes and the rejected bounces */
+	if (event != BUTTON_CORE_NONE || me->core.pressed != was_pressed) {
+		button_trace(me, pressed, event, now);
+	}
+#endif /* CONFIG_BUTTON_TRACE */
+
+#ifdef CONFIG_BUTTON_COMBO
+	button_combo_post(me, was_pressed, now);
+#endif /* CONFIG_BUTTON_COMBO */
+
+	button_scan_post(me, event, now);
+#else
+	button_scan_post(me, button_core_sample(&me->core, &me->config, pressed,
+			now), now);
+#endif /* CONFIG_BUTTON_TRACE || CONFIG_BUTTON_COMBO */
+
+	/* Multiple click when the click window expires and repeats */
+	button_scan_post(me, button_core_tick(&me->core, &me->config, now), now);
+}
+
+static void button_scan_post(button_t *const me, button_core_event_t event,
+		button_time_t now) {
+	if (BUTTON_CORE_IS_CLICK(event)) {
+		button_post_event(me, (button_click_e)event,
+				button_core_count(&me->core, event), now, false);
+	}
+#ifdef CONFIG_BUTTON_STATS
+	else if (event == BUTTON_CORE_BOUNCE) {
+		__atomic_fetch_add(&me->stats.bounces, 1, __ATOMIC_RELAXED);
+	}
+#endif /* CONFIG_BUTTON_STATS */
+}
+
+#ifdef CONFIG_BUTTON_GROUP
+static void button_group_scan(button_group_t *const me, button_time_t now) {
+	/* Read all the group pins at once */
+#if SOC_GPIO_PIN_COUNT > 32
+	uint32_t sample = REG_READ(me->bank == 0 ? GPIO_IN_REG : GPIO_IN1_REG) & me->mask;
+#else
+	uint32_t sample = REG_READ(GPIO_IN_REG) & me->mask;
+#endif /* SOC_GPIO_PIN_COUNT > 32 */
+
+	/* Two bit vertical counters, a bit toggles after four equal samples */
+	uint32_t delta = sample ^ me->levels;
+
+#ifdef CONFIG_BUTTON_STATS
+	/* Count the counters reset before reaching four samples as bounces */
+	for (uint32_t bits = (me->count0 | me->count1) & ~delta; bits != 0; bits &= bits - 1) {
+		button_t *button = &me->buttons[__builtin_popcount(me->mask &
+				((1UL << __builtin_ctz(bits)) - 1))];
+
+		__atomic_fetch_add(&button->stats.bounces, 1, __ATOMIC_RELAXED);
+	}
+#endif /* CONFIG_BUTTON_STATS */
+
+	me->count1 = (me->count1 ^ me->count0) & delta;
+	me->count0 = ~me->count0 & delta;
+	uint32_t toggled = delta & ~(me->count0 | me->count1);
+	me->levels ^= toggled;
+
+	/* Classify the debounced level changes */
+	for (uint32_t bits = toggled; bits != 0; bits &= bits - 1) {
+		uint32_t bit = 1UL << __builtin_ctz(bits);
+		button_t *button = &me->buttons[__builtin_popcount(me->mask & (bit - 1))];
+		bool pressed = ((me->levels & bit) != 0) == (me->active_level != 0);
+
+#if defined(CONFIG_BUTTON_TRACE) || defined(CONFIG_BUTTON_COMBO)
+		button_core_event_t event = button_core_update(&button->core,
+				&button->config, pressed, now);
+
+#ifdef CONFIG_BUTTON_TRACE
+		button_trace(button, pressed, event, now);
+#endif /* CONFIG_BUTTON_TRACE */
+#ifdef CONFIG_BUTTON_COMBO
+		button_combo_post(button, !pressed, now);
+#endif /* CONFIG_BUTTON_COMBO */
+		button_scan_post(button, event, now);
+#else
+		button_scan_post(button, button_core_update(&button->core, &button->config,
+				pressed, now), now);
+#endif /* CONFIG_BUTTON_TRACE || CONFIG_BUTTON_COMBO */
+
+		if (button_core_deadline(&button->core, &button->config, now) >= 0) {
+			me->clicks |= bit;
+		}
+	}
+
+	/* Check the timed gestures only of the buttons waiting for them */
+	for (uint32_t bits = me->clicks; bits != 0; bits &= bits - 1) {
+		uint32_t bit = 1UL << __builtin_ctz(bits);
+		button_t *button = &me->buttons[__builtin_popcount(me->mask & (bit - 1))];
+
+		button_scan_post(button, button_core_tick(&button->core, &button->config,
+				now), now);
+
+		if (button_core_deadline(&button->core, &button->config, now) < 0) {
+			me->clicks &= ~bit;
+		}
+	}
+}
+#endif /* CONFIG_BUTTON_GROUP */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+
+#ifdef CONFIG_BUTTON_WAKEUP
+static esp_err_t button_wakeup_init(button_t *const me) {
+	/* Wake up from light sleep at the press level */
+	esp_err_t ret = gpio_wakeup_enable(me->gpio, BUTTON_PRESS_INTR(me));
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+	ret = esp_sleep_enable_gpio_wakeup();
+
+	if (ret != ESP_OK) {
+		return ret;
+	}
+
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+	/* Timestamp the wakeup press when the automatic light sleep ends */
+	if (!sleep_cb_registered) {
+		esp_pm_sleep_cbs_register_config_t cbs_config = {
+				.exit_cb = button_sleep_exit_cb,
+				.exit_cb_user_arg = NULL,
+				.exit_cb_prior = 0
+		};
+
+		ret = esp_pm_light_sleep_register_cbs(&cbs_config);
+
+		if (ret != ESP_OK) {
+			return ret;
+		}
+
+		sleep_cb_registered = true;
+	}
+#endif /* CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+	/* Only the RTC GPIOs can wake up the chip from deep sleep */
+	if (!esp_sleep_is_valid_wakeup_gpio(me->gpio)) {
+		ESP_LOGW(TAG, "GPIO %d can not wake up from deep sleep", me->gpio);
+		return ESP_OK;
+	}
+
+	/* The EXT1 wakeup mode is shared by all the pins */
+	if (ext1_mask != 0 && ext1_edge != me->edge) {
+		ESP_LOGW(TAG, "GPIO %d edge differs from the other deep sleep wakeup "
+				"buttons", me->gpio);
+		return ESP_OK;
+	}
+
+	ext1_mask |= 1ULL << me->gpio;
+	ext1_edge = me->edge;
+
+#if SOC_RTCIO_INPUT_OUTPUT_SUPPORTED
+	/* Keep the pull resistor of the button in deep sleep */
+	if (me->edge == BUTTON_EDGE_FALLING) {
+		rtc_gpio_pulldown_dis(me->gpio);
+		rtc_gpio_pullup_en(me->gpio);
+	}
+	else {
+		rtc_gpio_pullup_dis(me->gpio);
+		rtc_gpio_pulldown_en(me->gpio);
+	}
+#endif /* SOC_RTCIO_INPUT_OUTPUT_SUPPORTED */
+
+#if SOC_PM_SUPPORT_RTC_PERIPH_PD
+	esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+#endif /* SOC_PM_SUPPORT_RTC_PERIPH_PD */
+
+#if CONFIG_IDF_TARGET_ESP32
+	if (me->edge == BUTTON_EDGE_FALLING && ext1_mask != (1ULL << me->gpio)) {
+		ESP_LOGW(TAG, "All the buttons must be pressed to wake up from deep "
+				"sleep");
+	}
+#endif /* CONFIG_IDF_TARGET_ESP32 */
+
+	ret = button_ext1_update();
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+
+	/* Return error code */
+	return ret;
+}
+
+static void button_wakeup_deinit(button_t *const me) {
+	gpio_wakeup_disable(me->gpio);
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+	if (ext1_mask & (1ULL << me->gpio)) {
+		ext1_mask &= ~(1ULL << me->gpio);
+		button_ext1_update();
+	}
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+}
+
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static esp_err_t button_sleep_exit_cb(int64_t sleep_time_us, void *arg) {
+	/* The time source is already advanced by the RTC time slept */
+	button_time_t now = BUTTON_GET_TIME_FROM_ISR();
+	uint8_t num = __atomic_load_n(&buttons_num, __ATOMIC_ACQUIRE);
+
+	for (uint8_t i = 0; i < num; i++) {
+		button_t *button = __atomic_load_n(&buttons[i], __ATOMIC_ACQUIRE);
+
+		if (button == NULL) {
+			continue;
+		}
+
+		/* A pressed button still waiting for the press woke up the chip, handle
+		 * it now instead of when the interrupt is serviced */
+		if (!button->core.pressed &&
+				gpio_get_level(button->gpio) == BUTTON_ACTIVE_LEVEL(button) &&
+				__atomic_exchange_n(&button->armed, false, __ATOMIC_RELAXED)) {
+			button_edge_from_isr(button, now);
+		}
+	}
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+#endif /* CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+static esp_err_t button_ext1_update(void) {
+	if (ext1_mask == 0) {
+		return esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT1);
+	}
+
+#if CONFIG_IDF_TARGET_ESP32
+	/* ESP32 wakes up at the low level only when all the pins are low */
+	return esp_sleep_enable_ext1_wakeup(ext1_mask,
+			ext1_edge == BUTTON_EDGE_FALLING ? ESP_EXT1_WAKEUP_ALL_LOW :
+			ESP_EXT1_WAKEUP_ANY_HIGH);
+#else
+	return esp_sleep_enable_ext1_wakeup(ext1_mask,
+			ext1_edge == BUTTON_EDGE_FALLING ? ESP_EXT1_WAKEUP_ANY_LOW :
+			ESP_EXT1_WAKEUP_ANY_HIGH);
+#endif /* CONFIG_IDF_TARGET_ESP32 */
+}
+
+static void button_wakeup_replay(button_t *const me) {
+	me->wake_press = false;
+
+	if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT1 ||
+			!(esp_sleep_get_ext1_wakeup_status() & (1ULL << me->gpio))) {
+		return;
+	}
+
+	/* The press started before the boot, at the time origin. The debounce
+	 * timer handles its release */
+	me->armed = false;
+	me->wake_press = true;
+	button_edge_from_isr(me, 0);
+}
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
+#endif /* CONFIG_BUTTON_WAKEUP */
+
+#if (defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)) && \
+		CONFIG_BUTTON_ISR_CORE_ID >= 0
+static void button_isr_service_install_ipc(void *arg) {
+	*(esp_err_t *)arg = gpio_install_isr_service(BUTTON_ISR_FLAGS);
 }
+#endif /* (CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE) && CONFIG_BUTTON_ISR_CORE_ID >= 0 */
 
 /***************************** END OF FILE ************************************/
 
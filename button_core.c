@@ -0,0 +1,282 @@
+/**
+  ******************************************************************************
+  * @file           : button_core.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file provides the hardware independent debounce and
+  *                   click classifier shared by all the button engines
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "button_core.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#endif /* ESP_PLATFORM */
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private macro -------------------------------------------------------------*/
+/* Signed time from a time stamp, valid within BUTTON_CORE_TIME_MAX */
+#define BUTTON_CORE_SINCE(now, time)	((int32_t)((button_core_time_t)(now) - (time)))
+
+/* Functions called from the GPIO ISR */
+#ifdef ESP_PLATFORM
+#define BUTTON_CORE_ATTR	IRAM_ATTR
+#define BUTTON_CORE_DATA	DRAM_ATTR
+#else
+#define BUTTON_CORE_ATTR
+#define BUTTON_CORE_DATA
+#endif /* ESP_PLATFORM */
+
+/* Private function prototypes -----------------------------------------------*/
+static button_core_event_t BUTTON_CORE_ATTR button_core_release(
+		button_core_t *const me, const button_core_config_t *const config,
+		button_core_time_t elapsed_time, button_core_time_t now);
+static button_core_event_t BUTTON_CORE_ATTR button_core_clicks(
+		button_core_t *const me, uint8_t clicks);
+
+/* Private variables ---------------------------------------------------------*/
+/* The classifier state is kept in arrays by the scan backends */
+_Static_assert(sizeof(button_core_t) <= 12, "button_core_t is not packed");
+
+/* Click type of a multiple click by its number of clicks */
+BUTTON_CORE_DATA static const button_core_event_t click_events[] = {
+		BUTTON_CORE_NONE,
+		BUTTON_CLICK_SINGLE,
+		BUTTON_CLICK_DOUBLE,
+		BUTTON_CLICK_TRIPLE
+};
+
+/* Exported functions --------------------------------------------------------*/
+void button_core_init(button_core_t *const me) {
+	me->press_time = 0;
+	me->release_time = 0;
+	me->click_counter = 0;
+	me->clicks = 0;
+	me->repeats = 0;
+	me->pressed = false;
+	me->debounce_counter = 0;
+}
+
+button_core_event_t BUTTON_CORE_ATTR button_core_edge(button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now) {
+	if (!me->pressed) {
+		/* Get press start time */
+		me->press_time = (button_core_time_t)now;
+
+		return BUTTON_CORE_NONE;
+	}
+
+	/* Classify the press according button elapsed time pressed, a press that
+	 * already repeats is not a bounce */
+	button_core_time_t elapsed_time = (button_core_time_t)now - me->press_time;
+
+	if (elapsed_time < config->short_time && me->repeats == 0) {
+		return BUTTON_CORE_BOUNCE;
+	}
+
+	/* Released until the debounce time ends, no more repeats */
+	me->pressed = false;
+
+	return button_core_release(me, config, elapsed_time, (button_core_time_t)now);
+}
+
+void button_core_settle(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed) {
+	(void)config;
+
+	if (pressed && !me->pressed) {
+		/* The first repeat is timed from the press time */
+		me->repeats = 0;
+	}
+
+	me->pressed = pressed;
+}
+
+button_core_event_t button_core_sample(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed, button_time_t now) {
+	/* Accept a state change only when it is stable for the debounce time */
+	if (pressed == me->pressed) {
+		if (me->debounce_counter > 0) {
+			me->debounce_counter = 0;
+
+			return BUTTON_CORE_BOUNCE;
+		}
+
+		return BUTTON_CORE_NONE;
+	}
+
+	if (++me->debounce_counter < config->debounce_samples) {
+		return BUTTON_CORE_NONE;
+	}
+
+	me->debounce_counter = 0;
+
+	return button_core_update(me, config, pressed, now);
+}
+
+button_core_event_t button_core_update(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed, button_time_t now) {
+	if (pressed) {
+		/* Button pressed */
+		me->press_time = (button_core_time_t)now;
+		button_core_settle(me, config, true);
+
+		return BUTTON_CORE_NONE;
+	}
+
+	/* Button released, classify the press by its elapsed time */
+	me->pressed = false;
+
+	return button_core_release(me, config,
+			(button_core_time_t)now - me->press_time, (button_core_time_t)now);
+}
+
+button_core_event_t button_core_tick(button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now) {
+	/* Multiple click when the click window expires */
+	if (__atomic_load_n(&me->click_counter, __ATOMIC_RELAXED) != 0 &&
+			BUTTON_CORE_SINCE(now, me->release_time) >= (int32_t)config->click_time) {
+		/* The ISR can report the clicks concurrently, only one gets them */
+		return button_core_clicks(me, __atomic_exchange_n(&me->click_counter, 0,
+				__ATOMIC_RELAXED));
+	}
+
+	/* Repeat while the button is held, the press time moves to the repeat time
+	 * as the press is no longer classified by its length */
+	if (me->pressed && config->repeat_delay > 0) {
+		button_core_time_t step = me->repeats == 0 ? config->repeat_delay :
+				config->repeat_period;
+
+		if (BUTTON_CORE_SINCE(now, me->press_time) >= (int32_t)step) {
+			me->press_time += step;
+
+			if (me->repeats < UINT8_MAX) {
+				me->repeats++;
+			}
+
+			return BUTTON_CLICK_REPEAT;
+		}
+	}
+
+	return BUTTON_CORE_NONE;
+}
+
+button_time_t button_core_deadline(const button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now) {
+	button_time_t deadline = -1;
+
+	if (__atomic_load_n(&me->click_counter, __ATOMIC_RELAXED) != 0) {
+		deadline = (int32_t)config->click_time -
+				BUTTON_CORE_SINCE(now, me->release_time);
+
+		if (deadline < 0) {
+			deadline = 0;
+		}
+	}
+
+	if (me->pressed && config->repeat_delay > 0) {
+		button_time_t repeat = (int32_t)(me->repeats == 0 ? config->repeat_delay :
+				config->repeat_period) - BUTTON_CORE_SINCE(now, me->press_time);
+
+		if (repeat < 0) {
+			repeat = 0;
+		}
+
+		if (deadline < 0 || repeat < deadline) {
+			deadline = repeat;
+		}
+	}
+
+	return deadline;
+}
+
+uint8_t BUTTON_CORE_ATTR button_core_count(const button_core_t *const me,
+		button_core_event_t event) {
+	switch (event) {
+		case BUTTON_CLICK_SINGLE:
+		case BUTTON_CLICK_DOUBLE:
+		case BUTTON_CLICK_TRIPLE:
+		case BUTTON_CLICK_MULTI:
+			return me->clicks;
+		case BUTTON_CLICK_REPEAT:
+			return me->repeats;
+		default:
+			return 1;
+	}
+}
+
+/* Private functions ---------------------------------------------------------*/
+static button_core_event_t button_core_release(button_core_t *const me,
+		const button_core_config_t *const config, button_core_time_t elapsed_time,
+		button_core_time_t now) {
+	/* The repeats already reported the hold */
+	if (config->repeat_delay > 0 && me->repeats > 0) {
+		return BUTTON_CORE_NONE;
+	}
+
+	if (elapsed_time < config->medium_time) {
+		me->release_time = now;
+
+		/* Increment click counter, the click timer can report it concurrently */
+		if (__atomic_add_fetch(&me->click_counter, 1, __ATOMIC_RELAXED) >=
+				config->max_clicks) {
+			return button_core_clicks(me, __atomic_exchange_n(&me->click_counter, 0,
+					__ATOMIC_RELAXED));
+		}
+
+		return BUTTON_CORE_CLICK;
+	}
+
+	if (elapsed_time < config->long_time) {
+		return BUTTON_CLICK_MEDIUM;
+	}
+
+	return BUTTON_CLICK_LONG;
+}
+
+static button_core_event_t button_core_clicks(button_core_t *const me,
+		uint8_t clicks) {
+	if (clicks == 0) {
+		return BUTTON_CORE_NONE;
+	}
+
+	me->clicks = clicks;
+
+	if (clicks < sizeof(click_events) / sizeof(click_events[0])) {
+		return click_events[clicks];
+	}
+
+	return BUTTON_CLICK_MULTI;
+}
+
+/***************************** END OF FILE ************************************/
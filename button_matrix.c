@@ -0,0 +1,386 @@
+/**
+  ******************************************************************************
+  * @file           : button_matrix.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file provides the matrix keypad backend built on the
+  *                   button classifier
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sdkconfig.h"
+
+#ifdef CONFIG_BUTTON_MATRIX
+#include "button_matrix.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+/* Key event record */
+typedef struct {
+	uint8_t key;															/*!< Key index */
+	uint8_t click;														/*!< Button click type */
+	uint8_t count;														/*!< Clicks or repeat number of the event */
+} button_matrix_event_t;
+
+/* Private macro -------------------------------------------------------------*/
+/* Core of the callback task */
+#if CONFIG_BUTTON_TASK_CORE_ID >= 0
+#define BUTTON_MATRIX_TASK_CORE	CONFIG_BUTTON_TASK_CORE_ID
+#else
+#define BUTTON_MATRIX_TASK_CORE	tskNO_AFFINITY
+#endif /* CONFIG_BUTTON_TASK_CORE_ID >= 0 */
+
+/* Private function prototypes -----------------------------------------------*/
+static void button_matrix_scan(void *arg);
+static bool button_matrix_any(button_matrix_t *const me);
+static void button_matrix_rows(button_matrix_t *const me, uint32_t level);
+static void button_matrix_post(button_matrix_t *const me, uint8_t key,
+		button_core_event_t event);
+static void button_matrix_task(void *arg);
+static void button_matrix_teardown(button_matrix_t *const me);
+
+/* Private variables ---------------------------------------------------------*/
+/* Tag for debug */
+static const char * TAG = "button_matrix";
+
+/* Exported functions --------------------------------------------------------*/
+esp_err_t button_matrix_init(button_matrix_t *const me, const gpio_num_t *rows,
+		uint8_t rows_num, const gpio_num_t *cols, uint8_t cols_num,
+		button_core_t *keys, const button_config_t *const config,
+		UBaseType_t task_priority, uint32_t task_stack_size) {
+	ESP_LOGI(TAG, "Initializing button matrix...");
+
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+	/* Check arguments, the key index is 8 bits */
+	if (me == NULL || rows == NULL || cols == NULL || keys == NULL ||
+			rows_num == 0 || cols_num == 0 || rows_num * cols_num > UINT8_MAX + 1) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Convert the thresholds to the classifier time unit */
+	ret = button_config_to_core(config, CONFIG_BUTTON_MATRIX_SCAN_PERIOD,
+			&me->config);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid config argument");
+		return ret;
+	}
+
+	/* Initialize matrix variables with all the keys released */
+	me->rows = rows;
+	me->cols = cols;
+	me->rows_num = rows_num;
+	me->cols_num = cols_num;
+	me->keys = keys;
+	me->click_mask = 0;
+	me->key = 0;
+	me->click_count = 0;
+	me->dropped = 0;
+	me->queue = NULL;
+	me->task = NULL;
+	me->timer = NULL;
+	button_callbacks_init(&me->callbacks);
+
+	for (uint16_t i = 0; i < rows_num * cols_num; i++) {
+		button_core_init(&me->keys[i]);
+	}
+
+	/* Rows are open drain, two pressed keys of a column never short them */
+	gpio_config_t gpio_conf = {
+			.pin_bit_mask = 0,
+			.mode = GPIO_MODE_OUTPUT_OD,
+			.pull_up_en = GPIO_PULLUP_DISABLE,
+			.pull_down_en = GPIO_PULLDOWN_DISABLE,
+			.intr_type = GPIO_INTR_DISABLE
+	};
+
+	for (uint8_t i = 0; i < rows_num; i++) {
+		gpio_conf.pin_bit_mask |= 1ULL << rows[i];
+	}
+
+	ret = gpio_config(&gpio_conf);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to configure row GPIOs");
+		return ret;
+	}
+
+	gpio_conf.pin_bit_mask = 0;
+	gpio_conf.mode = GPIO_MODE_INPUT;
+	gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+
+	for (uint8_t i = 0; i < cols_num; i++) {
+		gpio_conf.pin_bit_mask |= 1ULL << cols[i];
+	}
+
+	ret = gpio_config(&gpio_conf);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to configure column GPIOs");
+		return ret;
+	}
+
+	/* Start idle, all the rows driven */
+	me->idle = true;
+	button_matrix_rows(me, 0);
+
+	/* Create the event queue and the callback task */
+	me->queue = xQueueCreate(CONFIG_BUTTON_MATRIX_QUEUE_SIZE,
+			sizeof(button_matrix_event_t));
+
+	if (me->queue == NULL) {
+		ESP_LOGE(TAG, "Failed to allocate memory to queue");
+		return ESP_ERR_NO_MEM;
+	}
+
+	if (xTaskCreatePinnedToCore(button_matrix_task,
+			"Button Matrix",
+			task_stack_size,
+			(void *)me,
+			task_priority,
+			&me->task,
+			BUTTON_MATRIX_TASK_CORE) != pdPASS) {
+		ESP_LOGE(TAG, "Failed to allocate memory to create task");
+		me->task = NULL;
+		button_matrix_teardown(me);
+		return ESP_ERR_NO_MEM;
+	}
+
+	/* Create and start the scan timer at the idle period */
+	const esp_timer_create_args_t timer_args = {
+			.callback = button_matrix_scan,
+			.arg = (void *)me,
+			.dispatch_method = ESP_TIMER_TASK,
+			.name = "Button matrix",
+			.skip_unhandled_events = true
+	};
+
+	ret = esp_timer_create(&timer_args, &me->timer);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to create scan timer");
+		me->timer = NULL;
+		button_matrix_teardown(me);
+		return ret;
+	}
+
+	ret = esp_timer_start_periodic(me->timer,
+			CONFIG_BUTTON_MATRIX_IDLE_PERIOD * 1000);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Failed to start scan timer");
+		button_matrix_teardown(me);
+		return ret;
+	}
+
+	/* Return ESP_OK */
+	return ret;
+}
+
+esp_err_t button_matrix_add_cb(button_matrix_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg) {
+	esp_err_t ret = button_callbacks_add(&me->callbacks, &me->click_mask,
+			click_type, function, arg);
+
+	if (ret == ESP_ERR_INVALID_ARG) {
+		ESP_LOGE(TAG, "Invalid argument");
+	}
+	else if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Callback table is full");
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+esp_err_t button_matrix_remove_cb(button_matrix_t *const me,
+		button_click_e click_type) {
+	esp_err_t ret = button_callbacks_remove(&me->callbacks, &me->click_mask,
+			click_type, NULL);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid argument");
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+uint8_t button_matrix_get_key(const button_matrix_t *const me) {
+	return me->key;
+}
+
+uint8_t button_matrix_get_click_count(const button_matrix_t *const me) {
+	return me->click_count;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void button_matrix_scan(void *arg) {
+	button_matrix_t *me = (button_matrix_t *)arg;
+
+	if (me->idle) {
+		/* Wait for a press with a single read of the columns */
+		if (!button_matrix_any(me)) {
+			return;
+		}
+
+		me->idle = false;
+		esp_timer_restart(me->timer, CONFIG_BUTTON_MATRIX_SCAN_PERIOD * 1000);
+	}
+
+	button_time_t now = esp_timer_get_time();
+	bool active = false;
+
+	button_matrix_rows(me, 1);
+
+	/* Drive one row at a time and sample the keys of all the columns */
+	for (uint8_t row = 0; row < me->rows_num; row++) {
+		gpio_set_level(me->rows[row], 0);
+		esp_rom_delay_us(CONFIG_BUTTON_MATRIX_SETTLE_TIME);
+
+		for (uint8_t col = 0; col < me->cols_num; col++) {
+			uint8_t key = BUTTON_MATRIX_KEY(me, row, col);
+			button_core_t *core = &me->keys[key];
+			bool pressed = gpio_get_level(me->cols[col]) == 0;
+
+			button_matrix_post(me, key, button_core_sample(core, &me->config,
+					pressed, now));
+
+			/* Report the expired click windows and the repeats */
+			button_core_event_t event;
+
+			while ((event = button_core_tick(core, &me->config, now)) !=
+					BUTTON_CORE_NONE) {
+				button_matrix_post(me, key, event);
+			}
+
+			if (core->pressed || core->debounce_counter != 0 ||
+					button_core_deadline(core, &me->config, now) >= 0) {
+				active = true;
+			}
+		}
+
+		gpio_set_level(me->rows[row], 1);
+	}
+
+	/* Slow down until the next press */
+	if (!active) {
+		me->idle = true;
+		button_matrix_rows(me, 0);
+		esp_timer_restart(me->timer, CONFIG_BUTTON_MATRIX_IDLE_PERIOD * 1000);
+	}
+}
+
+static bool button_matrix_any(button_matrix_t *const me) {
+	for (uint8_t col = 0; col < me->cols_num; col++) {
+		if (gpio_get_level(me->cols[col]) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void button_matrix_rows(button_matrix_t *const me, uint32_t level) {
+	for (uint8_t row = 0; row < me->rows_num; row++) {
+		gpio_set_level(me->rows[row], level);
+	}
+}
+
+static void button_matrix_post(button_matrix_t *const me, uint8_t key,
+		button_core_event_t event) {
+	/* Do not wake up the callback task without a callback to execute */
+	if (!BUTTON_CORE_IS_CLICK(event) ||
+			!(__atomic_load_n(&me->click_mask, __ATOMIC_RELAXED) & (1 << event))) {
+		return;
+	}
+
+	button_matrix_event_t record = {
+			.key = key,
+			.click = event,
+			.count = button_core_count(&me->keys[key], event)
+	};
+
+	/* Never wait in the scan timer */
+	if (xQueueSend(me->queue, &record, 0) != pdTRUE) {
+		me->dropped++;
+	}
+}
+
+static void button_matrix_task(void *arg) {
+	button_matrix_t *me = (button_matrix_t *)arg;
+	button_matrix_event_t record;
+	button_function_t table[CONFIG_BUTTON_MAX_CALLBACKS];
+
+	for (;;) {
+		if (xQueueReceive(me->queue, &record, portMAX_DELAY) != pdTRUE) {
+			continue;
+		}
+
+		/* Copy the callbacks, they can be edited while they are executed */
+		uint8_t num = button_callbacks_copy(&me->callbacks,
+				(button_click_e)record.click, table);
+
+		me->key = record.key;
+		me->click_count = record.count;
+
+		for (uint8_t i = 0; i < num; i++) {
+			table[i].function(table[i].arg);
+		}
+	}
+}
+
+static void button_matrix_teardown(button_matrix_t *const me) {
+	/* Undo button_matrix_init() in reverse order, the scan timer posts to the
+	 * queue and the task reads it */
+	if (me->timer != NULL) {
+		esp_timer_stop(me->timer);
+		esp_timer_delete(me->timer);
+		me->timer = NULL;
+	}
+
+	if (me->task != NULL) {
+		vTaskDelete(me->task);
+		me->task = NULL;
+	}
+
+	if (me->queue != NULL) {
+		vQueueDelete(me->queue);
+		me->queue = NULL;
+	}
+}
+#endif /* CONFIG_BUTTON_MATRIX */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,295 @@
+/**
+  ******************************************************************************
+  * @file           : button_source.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file provides the polled input source backend built
+  *                   on the button classifier
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sdkconfig.h"
+
+#ifdef CONFIG_BUTTON_SOURCE
+#include "button_source.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+
+/* Private macro -------------------------------------------------------------*/
+/* Core of the source task */
+#if CONFIG_BUTTON_TASK_CORE_ID >= 0
+#define BUTTON_SOURCE_TASK_CORE	CONFIG_BUTTON_TASK_CORE_ID
+#else
+#define BUTTON_SOURCE_TASK_CORE	tskNO_AFFINITY
+#endif /* CONFIG_BUTTON_TASK_CORE_ID >= 0 */
+
+/* Scan periods in ticks, at least one tick */
+#define BUTTON_SOURCE_TICKS(ms)	(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1)
+
+/* Private function prototypes -----------------------------------------------*/
+static void button_source_task(void *arg);
+static bool button_source_scan(button_source_t *const me);
+static void button_source_execute(button_source_t *const me, uint8_t key,
+		button_core_event_t event);
+static void IRAM_ATTR button_source_isr(void *arg);
+
+/* Private variables ---------------------------------------------------------*/
+/* Tag for debug */
+static const char * TAG = "button_source";
+
+/* Exported functions --------------------------------------------------------*/
+esp_err_t button_source_init(button_source_t *const me,
+		const button_source_config_t *const source, button_core_t *keys,
+		const button_config_t *const config, UBaseType_t task_priority,
+		uint32_t task_stack_size) {
+	ESP_LOGI(TAG, "Initializing button source...");
+
+	/* Error code variable */
+	esp_err_t ret = ESP_OK;
+
+	/* Check arguments */
+	if (me == NULL || source == NULL || source->read == NULL || keys == NULL ||
+			source->inputs_num == 0 || source->inputs_num > 32) {
+		ESP_LOGE(TAG, "Invalid argument");
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	/* Convert the thresholds to the classifier time unit */
+	ret = button_config_to_core(config, CONFIG_BUTTON_SOURCE_SCAN_PERIOD,
+			&me->config);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid config argument");
+		return ret;
+	}
+
+	/* Initialize source variables with all the inputs released */
+	me->source = *source;
+	me->keys = keys;
+	me->click_mask = 0;
+	me->key = 0;
+	me->click_count = 0;
+	me->errors = 0;
+	button_callbacks_init(&me->callbacks);
+
+	for (uint8_t i = 0; i < source->inputs_num; i++) {
+		button_core_init(&me->keys[i]);
+	}
+
+	if (source->int_gpio != GPIO_NUM_NC) {
+		/* The expander interrupt output is open drain and active low */
+		gpio_config_t gpio_conf = {
+				.pin_bit_mask = 1ULL << source->int_gpio,
+				.mode = GPIO_MODE_INPUT,
+				.pull_up_en = GPIO_PULLUP_ENABLE,
+				.pull_down_en = GPIO_PULLDOWN_DISABLE,
+				.intr_type = GPIO_INTR_NEGEDGE
+		};
+
+		ret = gpio_config(&gpio_conf);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to configure interrupt GPIO");
+			return ret;
+		}
+
+		ret = button_isr_service_install();
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to install GPIO ISR service");
+			return ret;
+		}
+	}
+
+	/* Create the source task, it waits until the interrupt handler is added */
+	if (xTaskCreatePinnedToCore(button_source_task,
+			"Button Source",
+			task_stack_size,
+			(void *)me,
+			task_priority,
+			&me->task,
+			BUTTON_SOURCE_TASK_CORE) != pdPASS) {
+		ESP_LOGE(TAG, "Failed to allocate memory to create task");
+		return ESP_ERR_NO_MEM;
+	}
+
+	if (source->int_gpio != GPIO_NUM_NC) {
+		/* The handler notifies the task, it is added last */
+		ret = gpio_isr_handler_add(source->int_gpio, button_source_isr,
+				(void *)me);
+
+		if (ret != ESP_OK) {
+			ESP_LOGE(TAG, "Failed to add GPIO ISR handler");
+			vTaskDelete(me->task);
+			me->task = NULL;
+			return ret;
+		}
+	}
+
+	/* Start scanning */
+	xTaskNotifyGive(me->task);
+
+	/* Return ESP_OK */
+	return ESP_OK;
+}
+
+esp_err_t button_source_add_cb(button_source_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg) {
+	esp_err_t ret = button_callbacks_add(&me->callbacks, &me->click_mask,
+			click_type, function, arg);
+
+	if (ret == ESP_ERR_INVALID_ARG) {
+		ESP_LOGE(TAG, "Invalid argument");
+	}
+	else if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Callback table is full");
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+esp_err_t button_source_remove_cb(button_source_t *const me,
+		button_click_e click_type) {
+	esp_err_t ret = button_callbacks_remove(&me->callbacks, &me->click_mask,
+			click_type, NULL);
+
+	if (ret != ESP_OK) {
+		ESP_LOGE(TAG, "Invalid argument");
+	}
+
+	/* Return error code */
+	return ret;
+}
+
+uint8_t button_source_get_key(const button_source_t *const me) {
+	return me->key;
+}
+
+uint8_t button_source_get_click_count(const button_source_t *const me) {
+	return me->click_count;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void button_source_task(void *arg) {
+	button_source_t *me = (button_source_t *)arg;
+	TickType_t timeout = portMAX_DELAY;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, timeout);
+
+		if (button_source_scan(me)) {
+			timeout = BUTTON_SOURCE_TICKS(CONFIG_BUTTON_SOURCE_SCAN_PERIOD);
+		}
+		else if (me->source.int_gpio == GPIO_NUM_NC) {
+			timeout = BUTTON_SOURCE_TICKS(CONFIG_BUTTON_SOURCE_IDLE_PERIOD);
+		}
+		else if (gpio_get_level(me->source.int_gpio) == 0) {
+			/* The line fell before the last read, no edge will come, poll it
+			 * at the scan period */
+			timeout = BUTTON_SOURCE_TICKS(CONFIG_BUTTON_SOURCE_SCAN_PERIOD);
+		}
+		else {
+			/* Keep the bus idle until the next change */
+			timeout = portMAX_DELAY;
+		}
+	}
+}
+
+static bool button_source_scan(button_source_t *const me) {
+	uint32_t levels;
+
+	/* Keep the last state on a bus error */
+	if (me->source.read(me->source.ctx, &levels) != ESP_OK) {
+		me->errors++;
+		return true;
+	}
+
+	button_time_t now = esp_timer_get_time();
+	uint32_t pressed = levels ^ me->source.active_low;
+	bool active = false;
+
+	for (uint8_t key = 0; key < me->source.inputs_num; key++) {
+		button_core_t *core = &me->keys[key];
+
+		button_source_execute(me, key, button_core_sample(core, &me->config,
+				(pressed >> key) & 1, now));
+
+		/* Report the expired click windows and the repeats */
+		button_core_event_t event;
+
+		while ((event = button_core_tick(core, &me->config, now)) !=
+				BUTTON_CORE_NONE) {
+			button_source_execute(me, key, event);
+		}
+
+		if (core->pressed || core->debounce_counter != 0 ||
+				button_core_deadline(core, &me->config, now) >= 0) {
+			active = true;
+		}
+	}
+
+	return active;
+}
+
+static void button_source_execute(button_source_t *const me, uint8_t key,
+		button_core_event_t event) {
+	button_function_t table[CONFIG_BUTTON_MAX_CALLBACKS];
+
+	if (!BUTTON_CORE_IS_CLICK(event) ||
+			!(__atomic_load_n(&me->click_mask, __ATOMIC_RELAXED) & (1 << event))) {
+		return;
+	}
+
+	/* Copy the callbacks, they can be edited while they are executed */
+	uint8_t num = button_callbacks_copy(&me->callbacks, (button_click_e)event,
+			table);
+
+	me->key = key;
+	me->click_count = button_core_count(&me->keys[key], event);
+
+	for (uint8_t i = 0; i < num; i++) {
+		table[i].function(table[i].arg);
+	}
+}
+
+static void IRAM_ATTR button_source_isr(void *arg) {
+	button_source_t *me = (button_source_t *)arg;
+	BaseType_t woken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(me->task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+#endif /* CONFIG_BUTTON_SOURCE */
+
+/***************************** END OF FILE ************************************/
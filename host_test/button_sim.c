@@ -0,0 +1,543 @@
+/**
+  ******************************************************************************
+  * @file           : button_sim.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : Host simulation and benchmark of the button classifier,
+  *                   replays edge traces through the timers and scan engines
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "button_core.h"
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+/* Input level change, level 1 is pressed */
+typedef struct {
+	button_time_t time;
+	uint8_t level;
+} sim_edge_t;
+
+/* Edge trace */
+typedef struct {
+	sim_edge_t *edges;
+	size_t num;
+	size_t size;
+} sim_trace_t;
+
+/* Classified clicks recorded per replay */
+#define SIM_MAX_CLICKS		16
+
+/* Classified clicks of one replay */
+typedef struct {
+	uint8_t clicks[SIM_MAX_CLICKS];
+	size_t num;
+	uint32_t steps;														/*!< Classifier calls */
+} sim_result_t;
+
+/* Simulated engines */
+typedef enum {
+	SIM_ENGINE_TIMERS = 0,
+	SIM_ENGINE_SCAN,
+	SIM_ENGINE_MAX
+} sim_engine_e;
+
+/* Synthetic trace with its expected clicks */
+typedef struct {
+	const char *name;
+	void (* build)(sim_trace_t *trace);
+	uint8_t expected[SIM_MAX_CLICKS];
+	size_t expected_num;
+	uint8_t must_pass;												/*!< Engines mask that must classify it */
+	uint8_t max_clicks;												/*!< Clicks reported at once, 0 for the default */
+	uint32_t repeat_delay;										/*!< Repeat delay in milliseconds */
+} sim_scenario_t;
+
+/* Private macro -------------------------------------------------------------*/
+/* Component defaults, times in milliseconds */
+#define SIM_SHORT_TIME		30
+#define SIM_MEDIUM_TIME		3000
+#define SIM_LONG_TIME			10000
+#define SIM_CLICK_TIME		(SIM_SHORT_TIME * 8)
+#define SIM_SCAN_PERIOD		5
+
+/* Time conversions to microseconds */
+#define MS(x)							((button_time_t)(x) * 1000)
+
+/* Engines masks */
+#define SIM_TIMERS				(1 << SIM_ENGINE_TIMERS)
+#define SIM_SCAN					(1 << SIM_ENGINE_SCAN)
+#define SIM_ALL						(SIM_TIMERS | SIM_SCAN)
+
+/* Benchmark repetitions of every trace */
+#define SIM_BENCH_RUNS		2000
+
+/* Repeat period of the repeat traces */
+#define SIM_REPEAT_PERIOD	100
+
+/* Time after the last edge to let the timers expire */
+#define SIM_TAIL_TIME			MS(SIM_LONG_TIME)
+
+/* Private function prototypes -----------------------------------------------*/
+static void trace_add(sim_trace_t *trace, button_time_t time, uint8_t level);
+static void trace_press(sim_trace_t *trace, button_time_t time,
+		button_time_t duration, uint32_t bounces);
+static int trace_load(sim_trace_t *trace, const char *path);
+static void sim_timers(const sim_trace_t *trace,
+		const button_core_config_t *config, sim_result_t *result);
+static void sim_scan(const sim_trace_t *trace,
+		const button_core_config_t *config, sim_result_t *result);
+static void sim_click(sim_result_t *result, button_core_event_t event);
+static uint32_t sim_random(void);
+static double sim_now_ns(void);
+
+static void build_clean_single(sim_trace_t *trace);
+static void build_bouncy_single(sim_trace_t *trace);
+static void build_double(sim_trace_t *trace);
+static void build_two_singles(sim_trace_t *trace);
+static void build_medium(sim_trace_t *trace);
+static void build_long(sim_trace_t *trace);
+static void build_glitch(sim_trace_t *trace);
+static void build_chatter(sim_trace_t *trace);
+static void build_triple(sim_trace_t *trace);
+static void build_five(sim_trace_t *trace);
+static void build_repeat(sim_trace_t *trace);
+
+/* Private variables ---------------------------------------------------------*/
+static const button_core_config_t timers_config = {
+		.short_time = MS(SIM_SHORT_TIME),
+		.medium_time = MS(SIM_MEDIUM_TIME),
+		.long_time = MS(SIM_LONG_TIME),
+		.click_time = MS(SIM_CLICK_TIME),
+		.repeat_delay = 0,
+		.repeat_period = MS(SIM_REPEAT_PERIOD),
+		.max_clicks = 2,
+		.debounce_samples = 1
+};
+
+static const button_core_config_t scan_config = {
+		.short_time = MS(SIM_SHORT_TIME),
+		.medium_time = MS(SIM_MEDIUM_TIME),
+		.long_time = MS(SIM_LONG_TIME),
+		.click_time = MS(SIM_CLICK_TIME),
+		.repeat_delay = 0,
+		.repeat_period = MS(SIM_REPEAT_PERIOD),
+		.max_clicks = 2,
+		.debounce_samples = SIM_SHORT_TIME / SIM_SCAN_PERIOD
+};
+
+static const char *engine_names[SIM_ENGINE_MAX] = {"timers", "scan"};
+
+static const char *click_names[BUTTON_CLICK_MAX] = {"SINGLE", "MEDIUM", "LONG",
+		"DOUBLE", "TRIPLE", "MULTI", "REPEAT"};
+
+static void (* const engines[SIM_ENGINE_MAX])(const sim_trace_t *,
+		const button_core_config_t *, sim_result_t *) = {sim_timers, sim_scan};
+
+static const button_core_config_t *const configs[SIM_ENGINE_MAX] = {
+		&timers_config, &scan_config};
+
+static const sim_scenario_t scenarios[] = {
+		{"clean single", build_clean_single, {BUTTON_CLICK_SINGLE}, 1, SIM_ALL, 0, 0},
+		{"bouncy single", build_bouncy_single, {BUTTON_CLICK_SINGLE}, 1, SIM_ALL, 0, 0},
+		{"rapid double", build_double, {BUTTON_CLICK_DOUBLE}, 1, SIM_ALL, 0, 0},
+		{"two singles", build_two_singles, {BUTTON_CLICK_SINGLE, BUTTON_CLICK_SINGLE}, 2, SIM_ALL, 0, 0},
+		{"bouncy medium", build_medium, {BUTTON_CLICK_MEDIUM}, 1, SIM_ALL, 0, 0},
+		{"bouncy long", build_long, {BUTTON_CLICK_LONG}, 1, SIM_ALL, 0, 0},
+		{"short glitch", build_glitch, {0}, 0, SIM_ALL, 0, 0},
+		{"1000 Hz chatter", build_chatter, {0}, 0, SIM_SCAN, 0, 0},
+		{"triple click", build_triple, {BUTTON_CLICK_TRIPLE}, 1, SIM_ALL, 3, 0},
+		{"five clicks", build_five, {BUTTON_CLICK_MULTI}, 1, SIM_ALL, 8, 0},
+		{"hold repeat", build_repeat, {BUTTON_CLICK_REPEAT, BUTTON_CLICK_REPEAT,
+				BUTTON_CLICK_REPEAT, BUTTON_CLICK_REPEAT, BUTTON_CLICK_REPEAT,
+				BUTTON_CLICK_REPEAT}, 6, SIM_ALL, 0, 500}
+};
+
+static uint32_t random_state = 1;
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char **argv) {
+	sim_trace_t trace = {0};
+	sim_result_t result;
+	int failed = 0;
+
+	/* Replay a recorded trace and print its clicks */
+	if (argc > 1) {
+		if (trace_load(&trace, argv[1]) != 0) {
+			fprintf(stderr, "Failed to read %s\n", argv[1]);
+			return 1;
+		}
+
+		for (int e = 0; e < SIM_ENGINE_MAX; e++) {
+			engines[e](&trace, configs[e], &result);
+			printf("%-7s %zu edges, %u steps:", engine_names[e], trace.num,
+					result.steps);
+
+			for (size_t i = 0; i < result.num; i++) {
+				printf(" %s", click_names[result.clicks[i]]);
+			}
+
+			printf("\n");
+		}
+
+		free(trace.edges);
+
+		return 0;
+	}
+
+	/* Classify the synthetic traces with every engine */
+	size_t scenarios_num = sizeof(scenarios) / sizeof(scenarios[0]);
+	size_t passed[SIM_ENGINE_MAX] = {0};
+	size_t edges = 0;
+	uint64_t steps[SIM_ENGINE_MAX] = {0};
+	double ns[SIM_ENGINE_MAX] = {0};
+
+	printf("%-16s %6s %-14s %-14s\n", "trace", "edges", "timers", "scan");
+
+	for (size_t s = 0; s < scenarios_num; s++) {
+		const sim_scenario_t *scenario = &scenarios[s];
+
+		trace.num = 0;
+		random_state = 1;
+		scenario->build(&trace);
+		edges += trace.num;
+		printf("%-16s %6zu", scenario->name, trace.num);
+
+		for (int e = 0; e < SIM_ENGINE_MAX; e++) {
+			button_core_config_t config = *configs[e];
+
+			if (scenario->max_clicks) {
+				config.max_clicks = scenario->max_clicks;
+			}
+
+			config.repeat_delay = MS(scenario->repeat_delay);
+			engines[e](&trace, &config, &result);
+			steps[e] += result.steps;
+
+			bool ok = result.num == scenario->expected_num &&
+					memcmp(result.clicks, scenario->expected, result.num) == 0;
+
+			passed[e] += ok;
+
+			if (!ok && (scenario->must_pass & (1 << e))) {
+				failed++;
+			}
+
+			printf(" %-14s", ok ? "ok" : (scenario->must_pass & (1 << e)) ?
+					"FAIL" : "miss (known)");
+
+			/* Measure the replay time */
+			double start = sim_now_ns();
+
+			for (int i = 0; i < SIM_BENCH_RUNS; i++) {
+				engines[e](&trace, &config, &result);
+			}
+
+			ns[e] += sim_now_ns() - start;
+		}
+
+		printf("\n");
+	}
+
+	printf("\n%-7s %9s %10s %9s\n", "engine", "accuracy", "steps/edge", "ns/edge");
+
+	for (int e = 0; e < SIM_ENGINE_MAX; e++) {
+		printf("%-7s %4zu/%-4zu %10.2f %9.1f\n", engine_names[e], passed[e],
+				scenarios_num, (double)steps[e] / edges,
+				ns[e] / ((double)edges * SIM_BENCH_RUNS));
+	}
+
+	printf("\nclassifier state %zu bytes per button\n", sizeof(button_core_t));
+
+	free(trace.edges);
+
+	return failed ? 1 : 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void trace_add(sim_trace_t *trace, button_time_t time, uint8_t level) {
+	if (trace->num == trace->size) {
+		trace->size = trace->size ? trace->size * 2 : 64;
+		trace->edges = realloc(trace->edges, trace->size * sizeof(sim_edge_t));
+
+		if (trace->edges == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+
+	trace->edges[trace->num].time = time;
+	trace->edges[trace->num].level = level;
+	trace->num++;
+}
+
+static void trace_press(sim_trace_t *trace, button_time_t time,
+		button_time_t duration, uint32_t bounces) {
+	/* Bounces of 50 to 500 us at the press and at the release */
+	for (uint32_t i = 0; i < bounces; i++) {
+		trace_add(trace, time, 1);
+		time += 50 + sim_random() % 450;
+		trace_add(trace, time, 0);
+		time += 50 + sim_random() % 450;
+	}
+
+	trace_add(trace, time, 1);
+	time += duration;
+
+	for (uint32_t i = 0; i < bounces; i++) {
+		trace_add(trace, time, 0);
+		time += 50 + sim_random() % 450;
+		trace_add(trace, time, 1);
+		time += 50 + sim_random() % 450;
+	}
+
+	trace_add(trace, time, 0);
+}
+
+static int trace_load(sim_trace_t *trace, const char *path) {
+	FILE *file = fopen(path, "r");
+	char line[128];
+
+	if (file == NULL) {
+		return -1;
+	}
+
+	/* One "time_us,level" record per line, lines starting with # are comments */
+	while (fgets(line, sizeof(line), file) != NULL) {
+		long long time;
+		int level;
+
+		if (line[0] != '#' && sscanf(line, "%lld,%d", &time, &level) == 2) {
+			trace_add(trace, (button_time_t)time, level != 0);
+		}
+	}
+
+	fclose(file);
+
+	return 0;
+}
+
+/*
+ * Event driven model of the timers engine: the GPIO interrupt, the one-shot
+ * debounce timer and the one-shot click timer, which also runs the repeats.
+ */
+static void sim_timers(const sim_trace_t *trace,
+		const button_core_config_t *config, sim_result_t *result) {
+	button_core_t core;
+	button_core_event_t event;
+	button_time_t debounce_deadline = -1;
+	button_time_t click_deadline = -1;
+	uint8_t level = 0;
+	uint8_t intr_level = 1;										/* Level of the enabled edge */
+	bool intr_enabled = true;
+	size_t i = 0;
+
+	button_core_init(&core);
+	result->num = 0;
+	result->steps = 0;
+
+	for (;;) {
+		button_time_t edge_time = i < trace->num ? trace->edges[i].time : -1;
+		button_time_t next = edge_time;
+
+		if (debounce_deadline >= 0 && (next < 0 || debounce_deadline < next)) {
+			next = debounce_deadline;
+		}
+
+		if (click_deadline >= 0 && (next < 0 || click_deadline < next)) {
+			next = click_deadline;
+		}
+
+		if (next < 0) {
+			break;
+		}
+
+		if (next == debounce_deadline) {
+			/* Debounce timer, read the level and enable the next edge */
+			debounce_deadline = -1;
+			button_core_settle(&core, config, level);
+			result->steps++;
+			intr_level = !level;
+			intr_enabled = true;
+
+			if (level && config->repeat_delay > 0) {
+				button_time_t left = button_core_deadline(&core, config, next);
+
+				click_deadline = left < 0 ? -1 : next + left;
+			}
+		}
+		else if (next == click_deadline) {
+			/* Click timer */
+			do {
+				event = button_core_tick(&core, config, click_deadline);
+				sim_click(result, event);
+				result->steps++;
+			} while (event != BUTTON_CORE_NONE);
+
+			button_time_t left = button_core_deadline(&core, config, next);
+
+			click_deadline = left < 0 ? -1 : next + left;
+		}
+		else {
+			/* GPIO edge */
+			level = trace->edges[i++].level;
+
+			if (intr_enabled && level == intr_level) {
+				intr_enabled = false;
+				event = button_core_edge(&core, config, edge_time);
+				result->steps++;
+
+				if (event == BUTTON_CORE_CLICK) {
+					click_deadline = edge_time + config->click_time;
+				}
+
+				sim_click(result, event);
+				debounce_deadline = edge_time + config->short_time;
+			}
+		}
+	}
+}
+
+/* Periodic sampling model of the scan engine */
+static void sim_scan(const sim_trace_t *trace,
+		const button_core_config_t *config, sim_result_t *result) {
+	button_core_t core;
+	uint8_t level = 0;
+	size_t i = 0;
+	button_time_t end = trace->num ? trace->edges[trace->num - 1].time : 0;
+
+	button_core_init(&core);
+	result->num = 0;
+	result->steps = 0;
+
+	for (button_time_t now = 0; now <= end + SIM_TAIL_TIME; now += MS(SIM_SCAN_PERIOD)) {
+		while (i < trace->num && trace->edges[i].time <= now) {
+			level = trace->edges[i++].level;
+		}
+
+		sim_click(result, button_core_sample(&core, config, level, now));
+		sim_click(result, button_core_tick(&core, config, now));
+		result->steps += 2;
+
+		/* Skip the idle scans, they do not change the classifier state */
+		if (i == trace->num && !core.pressed &&
+				button_core_deadline(&core, config, now) < 0) {
+			break;
+		}
+	}
+}
+
+static void sim_click(sim_result_t *result, button_core_event_t event) {
+	if (BUTTON_CORE_IS_CLICK(event) && result->num < SIM_MAX_CLICKS) {
+		result->clicks[result->num++] = event;
+	}
+}
+
+/* Deterministic pseudo random numbers, the traces are the same on every run */
+static uint32_t sim_random(void) {
+	random_state = random_state * 1103515245 + 12345;
+
+	return random_state >> 16;
+}
+
+static double sim_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void build_clean_single(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(100), 0);
+}
+
+static void build_bouncy_single(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(150), 5);
+}
+
+static void build_double(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(80), 4);
+	trace_press(trace, MS(300), MS(80), 4);
+}
+
+static void build_two_singles(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(100), 3);
+	trace_press(trace, MS(700), MS(100), 3);
+}
+
+static void build_medium(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(4000), 5);
+}
+
+static void build_long(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(11000), 5);
+}
+
+static void build_glitch(sim_trace_t *trace) {
+	trace_add(trace, MS(100), 1);
+	trace_add(trace, MS(105), 0);
+}
+
+static void build_triple(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(60), 3);
+	trace_press(trace, MS(250), MS(60), 3);
+	trace_press(trace, MS(400), MS(60), 3);
+}
+
+static void build_five(sim_trace_t *trace) {
+	for (int i = 0; i < 5; i++) {
+		trace_press(trace, MS(100 + i * 150), MS(60), 2);
+	}
+}
+
+/* Held for six repeats, from 500 ms to 1000 ms */
+static void build_repeat(sim_trace_t *trace) {
+	trace_press(trace, MS(100), MS(1050), 4);
+}
+
+/* Contact chatter around 1000 Hz with a jittered period, never held */
+static void build_chatter(sim_trace_t *trace) {
+	button_time_t time = MS(100);
+
+	for (int i = 0; i < 200; i++) {
+		trace_add(trace, time, 1);
+		time += 300 + sim_random() % 400;
+		trace_add(trace, time, 0);
+		time += 300 + sim_random() % 400;
+	}
+}
+
+/***************************** END OF FILE ************************************/
@@ -46,11 +46,22 @@ extern "C" {
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
+#include "freertos/task.h"
 #include "freertos/timers.h"
+#include "freertos/semphr.h"
 
 #include "driver/gpio.h"
 
+#include "button_core.h"
+
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+#include "driver/gpio_filter.h"
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+#include "esp_event.h"
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
+
 /* Exported types ------------------------------------------------------------*/
 typedef void (* button_cb_t)(void *);
 
@@ -60,6 +71,12 @@ typedef struct {
 	void *arg;
 } button_function_t;
 
+/* Callbacks per click type of a button, a matrix keypad or an input source */
+typedef struct {
+	button_function_t function[BUTTON_CLICK_MAX][CONFIG_BUTTON_MAX_CALLBACKS];	/*!< Callbacks per click type */
+	uint8_t num[BUTTON_CLICK_MAX];						/*!< Callbacks registered per click type */
+} button_callbacks_t;
+
 typedef enum {
 	BUTTON_EDGE_FALLING = 0,
 	BUTTON_EDGE_RISING
@@ -71,32 +88,224 @@ typedef enum {
 	BUTTON_STATE_UP,
 } button_state_e;
 
-/**/
-typedef enum {
-	BUTTON_CLICK_SINGLE = 0,
-	BUTTON_CLICK_MEDIUM,
-	BUTTON_CLICK_LONG,
-	BUTTON_CLICK_DOUBLE,
-	BUTTON_CLICK_MAX
-} button_click_e;
+#ifdef CONFIG_BUTTON_STATS
+/* Button statistics of one click type, times in microseconds */
+typedef struct {
+	uint32_t count;														/*!< Dispatched events */
+	uint32_t latency_min;											/*!< Minimum latency from edge to callback */
+	uint32_t latency_avg;											/*!< Average latency from edge to callback */
+	uint32_t latency_max;											/*!< Maximum latency from edge to callback */
+	uint32_t duration_min;										/*!< Minimum callback duration */
+	uint32_t duration_avg;										/*!< Average callback duration */
+	uint32_t duration_max;										/*!< Maximum callback duration */
+} button_click_stats_t;
+
+/* Button statistics */
+typedef struct {
+	button_click_stats_t click[BUTTON_CLICK_MAX];	/*!< Statistics per click type */
+	uint32_t bounces;													/*!< Bounces rejected by the debounce */
+	uint32_t dropped;													/*!< Events dropped with the event queue full */
+	uint32_t coalesced;												/*!< Events merged into an event not dispatched yet */
+} button_stats_t;
+#endif /* CONFIG_BUTTON_STATS */
+
+#ifdef CONFIG_BUTTON_TRACE
+/* Edge trace record, also the export format: 8 bytes in little endian */
+typedef struct {
+	uint32_t timestamp;												/*!< Edge time in microseconds, low 32 bits */
+	uint8_t gpio;															/*!< Button GPIO number */
+	uint8_t level;														/*!< GPIO level after the edge */
+	uint8_t event;														/*!< Classifier decision, a button_click_e value or BUTTON_CORE_* */
+	uint8_t seq;															/*!< Record sequence number, low 8 bits */
+} button_trace_record_t;
+#endif /* CONFIG_BUTTON_TRACE */
+
+/* Button event record */
+typedef struct {
+	uint8_t id;																/*!< Button index in the button service */
+	uint8_t click;														/*!< Button click type */
+	uint8_t count;														/*!< Clicks or repeat number of the event */
+	uint8_t generation;												/*!< Registration of the button index that posted it */
+	button_time_t timestamp;									/*!< Event time in microseconds */
+} button_event_t;
+
+/* Button event ring slot */
+typedef struct {
+	uint32_t seq;															/*!< Slot sequence number */
+	button_event_t event;											/*!< Slot event record */
+} button_ring_slot_t;
+
+/* Lock-free multiple producer, single consumer event ring */
+typedef struct {
+	button_ring_slot_t *slots;								/*!< Ring slots storage */
+	uint32_t mask;														/*!< Ring size minus one */
+	uint32_t head;														/*!< Next slot to read */
+	uint32_t tail;														/*!< Next slot to write */
+	uint32_t dropped;													/*!< Events dropped with the ring full */
+	TaskHandle_t task;												/*!< Consumer task to notify */
+	SemaphoreHandle_t stop;										/*!< Stop request, given once the consumer task stops */
+} button_ring_t;
 
+/* Button instance, the state used by the ISR and the event path first and the
+ * configuration read only at init or by the callbacks after it */
 typedef struct {
-	button_state_e state;											/*!< Button state */
-	button_edge_e edge;												/*!< Button interrupt type */
-	gpio_num_t gpio;													/*!< Button GPIO number */
-	TickType_t tick_counter;									/*!< Tick counter */
-	button_function_t function[BUTTON_CLICK_MAX];
-	EventGroupHandle_t event_group;						/*!< Button FreeRTOS event group */
-	UBaseType_t task_priority;								/*!< Button FreeRTOS task priority */
-	uint32_t task_stack_size;									/*!< Button FreeRTOS task stack size */
+	button_core_t core;												/*!< Button debounce and click classifier state */
+	uint8_t click_mask;												/*!< Click types with a callback, bit per button_click_e */
+	uint8_t pending[BUTTON_CLICK_MAX];				/*!< Events posted and not dispatched per click type, saturating */
+	uint8_t event_count;											/*!< Events merged in the running callback */
+	uint8_t click_count;											/*!< Clicks or repeat number of the running callback */
+	uint8_t gpio;															/*!< Button GPIO number */
+	uint8_t edge;															/*!< Button interrupt type, button_edge_e */
+#ifdef CONFIG_BUTTON_REGISTRY
+	uint8_t id;																/*!< Button index in the button registry */
+	uint8_t generation;												/*!< Registration of the button index */
+#endif /* CONFIG_BUTTON_REGISTRY */
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+#if defined(CONFIG_BUTTON_WAKEUP) || defined(CONFIG_BUTTON_ISR_ANYEDGE)
+	bool armed;																/*!< GPIO interrupt enabled for the next edge */
+#endif /* CONFIG_BUTTON_WAKEUP || CONFIG_BUTTON_ISR_ANYEDGE */
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+	button_core_time_t edge_time;							/*!< Edge that started the debounce time */
+	button_core_time_t bounce_time;						/*!< Last bounce dropped in the debounce time */
+	button_core_time_t bounce_estimate;				/*!< Learned bounce time in microseconds */
+	button_core_time_t bounce_peak;						/*!< Longest bounce since the estimate changed */
+	uint8_t bounce_quiet;											/*!< Settles since the estimate changed */
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+#ifdef CONFIG_BUTTON_DEEP_SLEEP_WAKEUP
+	bool wake_press;													/*!< Press replayed after a deep sleep wakeup */
+#endif /* CONFIG_BUTTON_DEEP_SLEEP_WAKEUP */
 	TimerHandle_t debounce_timer;							/*!< Button FreeRTOS debounce timer */
 	TimerHandle_t click_timer;								/*!< Button FreeRTOS double click timer */
-	uint8_t click_counter;										/*!< Button FreeRTOS double click timer */
+	TickType_t debounce_ticks;								/*!< Debounce timer period */
+	TickType_t click_ticks;										/*!< Click window timer period */
+#elif defined(CONFIG_BUTTON_GROUP)
+	bool grouped;															/*!< Button sampled by a button group */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+	button_core_config_t config;							/*!< Button classifier thresholds in microseconds */
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	button_ring_t ring;												/*!< Button event ring */
+	button_ring_slot_t ring_slots[CONFIG_BUTTON_TASK_QUEUE_SIZE];	/*!< Button event ring storage */
+	bool task_static;													/*!< Button task on buffers of the application */
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+	button_callbacks_t callbacks;							/*!< Button callbacks per click type */
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+	button_function_t isr_function[BUTTON_CLICK_MAX];	/*!< Button ISR callbacks */
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+#ifdef CONFIG_BUTTON_GLITCH_FILTER
+	gpio_glitch_filter_handle_t glitch_filter;	/*!< Button GPIO glitch filter */
+#endif /* CONFIG_BUTTON_GLITCH_FILTER */
+#ifdef CONFIG_BUTTON_STATS
+	button_stats_t stats;											/*!< Button statistics */
+	uint64_t latency_sum[BUTTON_CLICK_MAX];		/*!< Latency sum for the average */
+	uint64_t duration_sum[BUTTON_CLICK_MAX];	/*!< Callback duration sum for the average */
+#endif /* CONFIG_BUTTON_STATS */
 } button_t;
 
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+/* Callback execution handed over by the button task */
+typedef struct {
+	button_t *button;													/*!< Button of the event */
+	button_function_t function;								/*!< Callback function and argument */
+	uint8_t click;														/*!< Button click type */
+	uint8_t count;														/*!< Clicks or repeat number of the event */
+	uint8_t events;														/*!< Merged events */
+	button_time_t timestamp;									/*!< Event time in microseconds */
+} button_work_t;
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
+
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+/* Button event read by the application */
+typedef struct {
+	button_t *button;													/*!< Button of the event */
+	uint8_t click;														/*!< Button click type, button_click_e */
+	uint8_t count;														/*!< Clicks or repeat number of the event */
+	uint8_t events;														/*!< Merged events */
+	button_time_t timestamp;									/*!< Event time in microseconds */
+} button_pull_event_t;
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+#ifdef CONFIG_BUTTON_DISPATCH_EXECUTOR
+/* Executor of the callbacks, it must not block and returns false if the work
+ * can not be queued */
+typedef bool (* button_executor_t)(const button_work_t *work, void *arg);
+#endif /* CONFIG_BUTTON_DISPATCH_EXECUTOR */
+
+#ifdef CONFIG_BUTTON_GROUP
+/* Buttons of the same GPIO bank sampled together */
+typedef struct button_group_s {
+	uint32_t mask;														/*!< Group pins in the GPIO bank */
+	uint8_t bank;															/*!< GPIO bank, 0 for GPIO 0-31 and 1 for GPIO 32-63 */
+	uint8_t active_level;											/*!< GPIO level of a pressed button */
+	uint32_t levels;													/*!< Debounced GPIO levels */
+	uint32_t count0;													/*!< Vertical debounce counter low bits */
+	uint32_t count1;													/*!< Vertical debounce counter high bits */
+	uint32_t clicks;													/*!< Buttons waiting for a click window or a repeat */
+	button_t *buttons;												/*!< Group buttons in ascending GPIO order */
+	struct button_group_s *next;							/*!< Next registered group */
+} button_group_t;
+#endif /* CONFIG_BUTTON_GROUP */
+
+/* Button static allocation buffers */
+typedef struct {
+#ifdef CONFIG_BUTTON_TASK_MODE_PER_BUTTON
+	StaticTask_t task;												/*!< Button task control block */
+	StackType_t *task_stack;									/*!< Button task stack of task_stack_size bytes */
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+#ifdef CONFIG_BUTTON_ENGINE_TIMERS
+	StaticTimer_t debounce_timer;							/*!< Button debounce timer control block */
+	StaticTimer_t click_timer;								/*!< Button double click timer control block */
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS */
+#if !defined(CONFIG_BUTTON_TASK_MODE_PER_BUTTON) && !defined(CONFIG_BUTTON_ENGINE_TIMERS)
+	uint8_t reserved;													/*!< Nothing to allocate in this mode */
+#endif
+} button_static_t;
+
+/* Button thresholds, times in milliseconds up to 35 minutes */
+typedef struct {
+	uint32_t debounce_time;										/*!< Minimum stable time of a level, shorter presses are bounces */
+	uint32_t click_time;											/*!< Window for the next click of a multiple click */
+	uint32_t medium_time;											/*!< Minimum medium press time */
+	uint32_t long_time;												/*!< Minimum long press time */
+	uint32_t repeat_delay;										/*!< Hold time of the first repeat, 0 disables the repeat */
+	uint32_t repeat_period;										/*!< Time between repeats */
+	uint8_t max_clicks;												/*!< Clicks reported without waiting for the window */
+} button_config_t;
+
 /* Exported constants --------------------------------------------------------*/
+#ifdef CONFIG_BUTTON_DISPATCH_ESP_EVENT
+/* Event base of the button events, the event id is the button_click_e value
+ * and the event data a button_work_t */
+ESP_EVENT_DECLARE_BASE(BUTTON_EVENT);
+#endif /* CONFIG_BUTTON_DISPATCH_ESP_EVENT */
 
 /* Exported macro ------------------------------------------------------------*/
+/* Button thresholds from the configuration menu */
+#define BUTTON_CONFIG_DEFAULT() {														\
+		.debounce_time = CONFIG_BUTTON_DEBOUNCE_SHORT_TIME,					\
+		.click_time = CONFIG_BUTTON_DEBOUNCE_SHORT_TIME * 8,				\
+		.medium_time = CONFIG_BUTTON_DEBOUNCE_MEDIUM_TIME,					\
+		.long_time = CONFIG_BUTTON_DEBOUNCE_LONG_TIME,							\
+		.repeat_delay = CONFIG_BUTTON_REPEAT_DELAY,									\
+		.repeat_period = CONFIG_BUTTON_REPEAT_PERIOD,								\
+		.max_clicks = CONFIG_BUTTON_MAX_CLICKS											\
+}
+
+/* Multiple click and repeat gestures accepted by button_set_gestures() */
+#define BUTTON_GESTURES_VALID(max_clicks, repeat_delay, repeat_period)	\
+		((max_clicks) >= 2 &&																	\
+		((repeat_delay) == 0 || (repeat_period) > 0) &&							\
+		(repeat_delay) <= BUTTON_CORE_TIME_MAX / 1000 &&						\
+		(repeat_period) <= BUTTON_CORE_TIME_MAX / 1000)
+
+/* Thresholds accepted by button_config_to_core() */
+#define BUTTON_CONFIG_VALID(config)																\
+		((config).debounce_time > 0 && (config).click_time > 0 &&		\
+		(config).medium_time > (config).debounce_time &&						\
+		(config).long_time > (config).medium_time &&								\
+		(config).long_time <= BUTTON_CORE_TIME_MAX / 1000 &&				\
+		(config).click_time <= BUTTON_CORE_TIME_MAX / 1000 &&				\
+		BUTTON_GESTURES_VALID((config).max_clicks, (config).repeat_delay,	\
+				(config).repeat_period))
 
 /* Exported functions prototypes ---------------------------------------------*/
 /**
@@ -108,16 +317,130 @@ typedef struct {
   * @param task_priority   : Button task priority
   * @param task_stack_size : Button task stack size
   *
+  * @note In shared service mode (CONFIG_BUTTON_TASK_MODE_SERVICE) task_priority
+  *       and task_stack_size are ignored, the service task is configured with
+  *       CONFIG_BUTTON_SERVICE_TASK_PRIORITY and
+  *       CONFIG_BUTTON_SERVICE_TASK_STACK_SIZE.
+  *
   * @retval
   * 	- ESP_OK on success
   * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if is out of memory or the button service is full
   */
+#if configSUPPORT_DYNAMIC_ALLOCATION
 esp_err_t button_init(button_t *const me, gpio_num_t gpio, button_edge_e edge,
 		UBaseType_t task_priority, uint32_t task_stack_size);
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+/**
+  * @brief Initialize a button instance without heap allocations
+  *
+  * The FreeRTOS objects of the button are created in the caller buffers, which
+  * must remain valid while the button is in use. The shared service task is
+  * always allocated statically by the component.
+  *
+  * @param me              : Pointer to button_t structure
+  * @param gpio            : GPIO number to attach button
+  * @param edge            : GPIO interrupt edge
+  * @param task_priority   : Button task priority
+  * @param task_stack_size : Button task stack size
+  * @param buffers         : Pointer to button_static_t structure
+  *
+  * @note The scan engine timer is created by esp_timer, which allocates it
+  *       once on the first registered button.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if the button service is full
+  */
+esp_err_t button_init_static(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		button_static_t *const buffers);
+
+/**
+  * @brief Initialize a button instance with its own thresholds
+  *
+  * The thresholds are converted once to the classifier time unit, the edge
+  * handling only compares integers.
+  *
+  * @param me              : Pointer to button_t structure
+  * @param gpio            : GPIO number to attach button
+  * @param edge            : GPIO interrupt edge
+  * @param task_priority   : Button task priority
+  * @param task_stack_size : Button task stack size
+  * @param config          : Pointer to button_config_t structure, NULL for
+  *                          BUTTON_CONFIG_DEFAULT()
+  * @param buffers         : Pointer to button_static_t structure, NULL to
+  *                          allocate the FreeRTOS objects from the heap
+  *
+  * @note With the timers engine the debounce time is rounded up to a FreeRTOS
+  *       tick, with the scan engine to a multiple of CONFIG_BUTTON_SCAN_PERIOD.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if is out of memory or the button service is full
+  */
+esp_err_t button_init_config(button_t *const me, gpio_num_t gpio,
+		button_edge_e edge, UBaseType_t task_priority, uint32_t task_stack_size,
+		const button_config_t *const config, button_static_t *const buffers);
+
+/**
+  * @brief Deinitialize a button instance
+  *
+  * The ISR handler is detached and the timers and the button task are deleted
+  * once their running callbacks return. The events not dispatched yet are
+  * discarded. Afterwards the instance and its static buffers can be reused by
+  * a new initialization.
+  *
+  * @param me : Pointer to button_t structure
+  *
+  * @note It blocks until the button callbacks end, it must not be called from
+  *       a button callback.
+  * @note With CONFIG_BUTTON_DISPATCH_EXECUTOR or CONFIG_BUTTON_DISPATCH_ESP_EVENT
+  *       the works already handed over reference the instance until they are
+  *       executed.
+  * @note With CONFIG_BUTTON_DISPATCH_PULL the events already read reference
+  *       the instance.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_INVALID_STATE if it is called from a button callback
+  * 	- ESP_ERR_NOT_SUPPORTED if the button belongs to a button group
+  */
+esp_err_t button_deinit(button_t *const me);
+
+#ifdef CONFIG_BUTTON_GROUP
+/**
+  * @brief Initialize a group of buttons of the same GPIO bank
+  *
+  * Every set bit of gpio_mask is one button. The buttons are initialized in the
+  * caller array in ascending GPIO order and their callbacks are added with
+  * button_add_cb() as for any other button.
+  *
+  * @param me        : Pointer to button_group_t structure
+  * @param gpio_mask : Bit mask of the GPIO numbers of the buttons
+  * @param edge      : GPIO interrupt edge of all the buttons
+  * @param buttons   : Array of as many button_t as bits set in gpio_mask
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid or the pins are not in
+  * 	  the same GPIO bank
+  * 	- ESP_ERR_NO_MEM if the button registry is full
+  */
+esp_err_t button_group_init(button_group_t *const me, uint64_t gpio_mask,
+		button_edge_e edge, button_t *buttons);
+#endif /* CONFIG_BUTTON_GROUP */
 
 /**
   * @brief Add a button callback function
   *
+  * Up to CONFIG_BUTTON_MAX_CALLBACKS callbacks can be added for the same
+  * click type, they are executed in the order they were added.
+  *
   * @param me         : Pointer to button_t structure
   * @param click_type : Button press time to register callback function
   * @param function   : Callback function code
@@ -125,14 +448,16 @@ esp_err_t button_init(button_t *const me, gpio_num_t gpio, button_edge_e edge,
   *
   * @retval
   * 	- ESP_OK on success
-  * 	- ESP_NO_MEM if is out of memory
+  * 	- ESP_ERR_NO_MEM if the click type has no free callback entry
   * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NOT_SUPPORTED with CONFIG_BUTTON_DISPATCH_PULL, the events are
+  * 	  read with button_get_event()
   */
 esp_err_t button_add_cb(button_t *const me,	button_click_e click_type,
 		button_cb_t function, void * arg);
 
 /**
-  * @brief Remove a button callback function
+  * @brief Remove all the callback functions of a click type
   *
   * @param me         : Pointer to button_t structure
   * @param click_type : Button press time to unregister callback function
@@ -141,9 +466,426 @@ esp_err_t button_add_cb(button_t *const me,	button_click_e click_type,
   * @retval
   * 	- ESP_OK on success
   * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NOT_SUPPORTED with CONFIG_BUTTON_DISPATCH_PULL
   */
 esp_err_t button_remove_cb(button_t *const me, button_click_e click_type);
 
+/**
+  * @brief Remove one callback function of a click type
+  *
+  * The last callback of the click type takes the place of the removed one.
+  *
+  * @param me         : Pointer to button_t structure
+  * @param click_type : Button press time to unregister callback function
+  * @param function   : Callback function code
+  * @param arg        : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NOT_FOUND if the callback is not registered
+  */
+esp_err_t button_remove_cb_function(button_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg);
+
+/**
+  * @brief Get the number of events handled by the running callback
+  *
+  * While an event waits to be dispatched the next events of the same click
+  * type are merged into it, the callback runs once for all of them. The count
+  * saturates at UINT8_MAX.
+  *
+  * @param me : Pointer to button_t structure
+  *
+  * @retval Number of merged events, at least 1 inside a callback
+  */
+uint8_t button_get_event_count(const button_t *const me);
+
+/**
+  * @brief Get the clicks of the multiple click or the repeat number handled by
+  *        the running callback
+  *
+  * @param me : Pointer to button_t structure
+  *
+  * @retval Clicks of BUTTON_CLICK_SINGLE, BUTTON_CLICK_DOUBLE,
+  *         BUTTON_CLICK_TRIPLE and BUTTON_CLICK_MULTI, repeat number of
+  *         BUTTON_CLICK_REPEAT, 1 for the other click types
+  */
+uint8_t button_get_click_count(const button_t *const me);
+
+#ifdef CONFIG_BUTTON_DISPATCH_EXECUTOR
+/**
+  * @brief Set the executor of the button callbacks
+  *
+  * The button task calls the executor once per callback instead of executing
+  * it. The executor queues the work, without blocking, and the application
+  * executes it later with button_work_run().
+  *
+  * @param executor : Executor function, NULL to execute the callbacks in the
+  *                   button task
+  * @param arg      : Pointer to executor function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  */
+esp_err_t button_set_executor(button_executor_t executor, void *arg);
+#endif /* CONFIG_BUTTON_DISPATCH_EXECUTOR */
+
+#ifdef CONFIG_BUTTON_DISPATCH_WORK
+/**
+  * @brief Execute a callback handed over by the button task
+  *
+  * button_get_event_count() and button_get_click_count() return the values of
+  * the work inside the callback, the button ones are not written, so any task
+  * can execute the works.
+  *
+  * @param work : Pointer to button_work_t structure
+  */
+void button_work_run(const button_work_t *work);
+#endif /* CONFIG_BUTTON_DISPATCH_WORK */
+
+#ifdef CONFIG_BUTTON_DISPATCH_PULL
+/**
+  * @brief Wait for the next event of any button
+  *
+  * The events are read in the order they were posted. While an event waits to
+  * be read the next events of the same button and click type are merged into
+  * it.
+  *
+  * @param event   : Pointer to button_pull_event_t structure to fill
+  * @param timeout : Maximum time to wait in ticks, 0 to return at once
+  *
+  * @note The events must be read by a single task. The task notification of
+  *       the calling task is used to wait.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_TIMEOUT if no event was posted within timeout
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_get_event(button_pull_event_t *const event,
+		TickType_t timeout);
+
+/**
+  * @brief Read the pending events of all the buttons without waiting
+  *
+  * @param events : Array of button_pull_event_t structures to fill
+  * @param num    : Size of the array
+  *
+  * @note The notes of button_get_event() apply.
+  *
+  * @retval Number of events read
+  */
+size_t button_poll_events(button_pull_event_t *const events, size_t num);
+
+/**
+  * @brief Select the click types of a button posted to the application
+  *
+  * All the click types are posted after the initialization.
+  *
+  * @param me   : Pointer to button_t structure
+  * @param mask : Click types, bit (1 << click_type) per button_click_e
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_set_event_mask(button_t *const me, uint8_t mask);
+#endif /* CONFIG_BUTTON_DISPATCH_PULL */
+
+/**
+  * @brief Change the thresholds of an initialized button
+  *
+  * With the timers engine the button interrupt is masked while the timer task
+  * applies the config, a press in progress goes on with the new thresholds.
+  * An invalid config leaves the current one in place.
+  *
+  * @param me     : Pointer to button_t structure
+  * @param config : Pointer to button_config_t structure
+  *
+  * @note With the scan engine the scan reads the config without a lock, call
+  *       it while the button is released. The debounce time of the buttons of
+  *       a button group is fixed to four scans.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_set_config(button_t *const me,
+		const button_config_t *const config);
+
+/**
+  * @brief Configure the multiple click and the press and hold repeat gestures
+  *        of a button
+  *
+  * A multiple click is reported when the click window expires after the last
+  * click, or at once when it reaches max_clicks. Presses held for repeat_delay
+  * report BUTTON_CLICK_REPEAT every repeat_period instead of a medium or long
+  * click. The defaults are CONFIG_BUTTON_MAX_CLICKS,
+  * CONFIG_BUTTON_REPEAT_DELAY and CONFIG_BUTTON_REPEAT_PERIOD.
+  *
+  * @param me            : Pointer to button_t structure
+  * @param max_clicks    : Clicks reported without waiting for the window, at
+  *                        least 2
+  * @param repeat_delay  : Hold time of the first repeat in milliseconds, 0
+  *                        disables the repeat
+  * @param repeat_period : Time between repeats in milliseconds
+  *
+  * @note Call it while the button is idle, before adding the callbacks.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_set_gestures(button_t *const me, uint8_t max_clicks,
+		uint32_t repeat_delay, uint32_t repeat_period);
+
+#ifdef CONFIG_BUTTON_COMBO
+/**
+  * @brief Add a callback function executed when several buttons are held
+  *        together
+  *
+  * The chord fires once all the buttons are pressed and held for hold_time,
+  * with hold_time 0 it fires on the last press. It fires again after one of
+  * the buttons is released and pressed again.
+  *
+  * @param members   : Array of pointers to the initialized buttons
+  * @param num       : Number of buttons, 2 to CONFIG_BUTTON_COMBO_MAX_LENGTH
+  * @param hold_time : Hold time in milliseconds
+  * @param suppress  : True to drop the clicks of the buttons reported after
+  *                    the chord fires, until each button is pressed again
+  * @param function  : Callback function code
+  * @param arg       : Pointer to callback function argument
+  *
+  * @note Only the first 64 registered buttons can be members. The callback
+  *       runs in the service task whatever the dispatch mode, and the
+  *       combinations of a button are removed by button_deinit().
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_NO_MEM if there are already CONFIG_BUTTON_MAX_COMBOS
+  * 	  combinations
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_add_chord(button_t *const *members, uint8_t num,
+		uint32_t hold_time, bool suppress, button_cb_t function, void *arg);
+
+/**
+  * @brief Add a callback function executed when buttons are pressed in order
+  *
+  * The sequence fires on its last press when every press follows the previous
+  * one within window. A button can appear more than once.
+  *
+  * @param members  : Array of pointers to the initialized buttons, in press
+  *                   order
+  * @param num      : Number of presses, 2 to CONFIG_BUTTON_COMBO_MAX_LENGTH
+  * @param window   : Maximum time between two presses in milliseconds
+  * @param suppress : True to drop the clicks of the buttons reported after
+  *                   the sequence fires, until each button is pressed again
+  * @param function : Callback function code
+  * @param arg      : Pointer to callback function argument
+  *
+  * @note The notes of button_add_chord() apply.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_NO_MEM if there are already CONFIG_BUTTON_MAX_COMBOS
+  * 	  combinations
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_add_sequence(button_t *const *members, uint8_t num,
+		uint32_t window, bool suppress, button_cb_t function, void *arg);
+
+/**
+  * @brief Remove the chords and sequences of a callback function
+  *
+  * @param function : Callback function code
+  * @param arg      : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_NOT_FOUND if no combination has the callback
+  */
+esp_err_t button_remove_combo(button_cb_t function, void *arg);
+#endif /* CONFIG_BUTTON_COMBO */
+
+#ifdef CONFIG_BUTTON_ADAPTIVE_DEBOUNCE
+/**
+  * @brief Get the debounce time learned for a button
+  *
+  * @param me : Pointer to button_t structure
+  *
+  * @retval Debounce time in microseconds, the shortest press accepted and the
+  *         time the edges are ignored after a press or a release
+  */
+uint32_t button_get_debounce_time(const button_t *const me);
+#endif /* CONFIG_BUTTON_ADAPTIVE_DEBOUNCE */
+
+#ifdef CONFIG_BUTTON_STATS
+/**
+  * @brief Get the statistics of a button
+  *
+  * The statistics are updated without locks, a snapshot taken while events are
+  * being handled can mix values from before and after one event. When the
+  * callbacks are handed to an executor or to the default event loop, the
+  * duration measures the handover of the callbacks, not their execution.
+  *
+  * @param me    : Pointer to button_t structure
+  * @param stats : Pointer to button_stats_t structure to fill
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_get_stats(button_t *const me, button_stats_t *const stats);
+#endif /* CONFIG_BUTTON_STATS */
+
+#ifdef CONFIG_BUTTON_TRACE
+/**
+  * @brief Copy the newest edge trace records, oldest first
+  *
+  * The trace ring is shared by all the buttons and keeps the last
+  * CONFIG_BUTTON_TRACE_SIZE edges. The records written while they are copied
+  * are not returned, the next dump gets them.
+  *
+  * @param buffer : Array of button_trace_record_t records to fill
+  * @param size   : Number of records of the buffer
+  * @param seq    : Sequence number of the first record copied, a gap with the
+  *                 end of the previous dump is the number of lost records. It
+  *                 can be NULL
+  *
+  * @retval Number of records copied
+  */
+size_t button_trace_dump(button_trace_record_t *const buffer, size_t size,
+		uint32_t *const seq);
+#endif /* CONFIG_BUTTON_TRACE */
+
+#ifdef CONFIG_BUTTON_ISR_CALLBACKS
+/**
+  * @brief Add a button ISR callback function
+  *
+  * The callback runs as soon as the click is classified, before the event is
+  * posted to the button task. It can run in interrupt context, so it must be
+  * placed in IRAM (IRAM_ATTR) and use only ISR safe APIs.
+  *
+  * @param me         : Pointer to button_t structure
+  * @param click_type : Button press time to register callback function
+  * @param function   : Callback function code
+  * @param arg        : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_add_isr_cb(button_t *const me, button_click_e click_type,
+		button_cb_t function, void * arg);
+
+/**
+  * @brief Remove a button ISR callback function
+  *
+  * @param me         : Pointer to button_t structure
+  * @param click_type : Button press time to unregister callback function
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_remove_isr_cb(button_t *const me, button_click_e click_type);
+#endif /* CONFIG_BUTTON_ISR_CALLBACKS */
+
+/**
+  * @brief Check the thresholds of a button backend and convert them to the
+  *        classifier config
+  *
+  * The thresholds must pass BUTTON_CONFIG_VALID(), the times are converted to
+  * microseconds and the debounce time to consecutive samples.
+  *
+  * @param config      : Pointer to button_config_t structure, NULL for
+  *                      BUTTON_CONFIG_DEFAULT()
+  * @param scan_period : Sampling period in milliseconds, 0 if every edge is a
+  *                      sample
+  * @param core        : Pointer to button_core_config_t structure, left
+  *                      untouched if the thresholds are invalid
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the thresholds are invalid
+  */
+esp_err_t button_config_to_core(const button_config_t *const config,
+		uint32_t scan_period, button_core_config_t *const core);
+
+/**
+  * @brief Remove all the callbacks of a button backend
+  *
+  * @param callbacks : Pointer to button_callbacks_t structure
+  */
+void button_callbacks_init(button_callbacks_t *const callbacks);
+
+/**
+  * @brief Append a callback of a button backend
+  *
+  * @param callbacks  : Pointer to button_callbacks_t structure
+  * @param click_mask : Click types with a callback, the click type bit is set
+  * @param click_type : Button click type
+  * @param function   : Callback function
+  * @param arg        : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if the click type has CONFIG_BUTTON_MAX_CALLBACKS
+  */
+esp_err_t button_callbacks_add(button_callbacks_t *const callbacks,
+		uint8_t *const click_mask, button_click_e click_type, button_cb_t function,
+		void *arg);
+
+/**
+  * @brief Remove the callbacks of a click type of a button backend
+  *
+  * @param callbacks  : Pointer to button_callbacks_t structure
+  * @param click_mask : Click types with a callback, the click type bit is
+  *                     cleared once it has none
+  * @param click_type : Button click type
+  * @param function   : Callback function and argument to remove, NULL to
+  *                     remove all the callbacks of the click type
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the click type is invalid
+  * 	- ESP_ERR_NOT_FOUND if the callback is not registered
+  */
+esp_err_t button_callbacks_remove(button_callbacks_t *const callbacks,
+		uint8_t *const click_mask, button_click_e click_type,
+		const button_function_t *function);
+
+/**
+  * @brief Copy the callbacks of a click type of a button backend
+  *
+  * The callbacks can be edited while the copy is executed.
+  *
+  * @param callbacks  : Pointer to button_callbacks_t structure
+  * @param click_type : Button click type
+  * @param table      : Copy of CONFIG_BUTTON_MAX_CALLBACKS entries
+  *
+  * @retval Number of callbacks copied
+  */
+uint8_t button_callbacks_copy(const button_callbacks_t *const callbacks,
+		button_click_e click_type, button_function_t *table);
+
+#if defined(CONFIG_BUTTON_ENGINE_TIMERS) || defined(CONFIG_BUTTON_SOURCE)
+/**
+  * @brief Install the GPIO ISR service of the button backends
+  *
+  * The service is allocated with the interrupt level, flags and core of the
+  * configuration menu. A service already installed is used as it is.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- Error code of gpio_install_isr_service() otherwise
+  */
+esp_err_t button_isr_service_install(void);
+#endif /* CONFIG_BUTTON_ENGINE_TIMERS || CONFIG_BUTTON_SOURCE */
+
 #ifdef __cplusplus
 }
 #endif
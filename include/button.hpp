@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * @file           : button.hpp
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file contains the header only C++ interface of the
+  *                   button component
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BUTTON_HPP_
+#define BUTTON_HPP_
+
+/* Includes ------------------------------------------------------------------*/
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "button.h"
+
+namespace button {
+
+/* Exported constants --------------------------------------------------------*/
+/* Thresholds from the configuration menu */
+inline constexpr button_config_t default_config = BUTTON_CONFIG_DEFAULT();
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief Check the thresholds with the rules of button_init_config()
+  *
+  * @param config : Button thresholds
+  *
+  * @retval True if button_init_config() accepts the thresholds
+  */
+constexpr bool config_valid(const button_config_t &config) {
+	return BUTTON_CONFIG_VALID(config);
+}
+
+/**
+  * @brief Check that no GPIO number is repeated
+  *
+  * @param gpios : GPIO numbers
+  *
+  * @retval True if every GPIO number appears once
+  */
+template <std::size_t N>
+constexpr bool gpios_unique(const std::array<gpio_num_t, N> &gpios) {
+	for (std::size_t i = 0; i < N; i++) {
+		for (std::size_t j = i + 1; j < N; j++) {
+			if (gpios[i] == gpios[j]) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Exported types ------------------------------------------------------------*/
+/**
+  * @brief Button with its GPIO, edge and thresholds fixed at compile time
+  *
+  * The thresholds are checked by the compiler and kept as a constant, the
+  * instance holds only the button_t. The callbacks are called through a
+  * trampoline specialised for each callable type, without type erasure or
+  * heap allocation.
+  *
+  * @tparam Gpio   : GPIO number to attach button
+  * @tparam Edge   : GPIO interrupt edge
+  * @tparam Config : Button thresholds
+  */
+template <gpio_num_t Gpio, button_edge_e Edge = BUTTON_EDGE_FALLING,
+		button_config_t Config = default_config>
+class gpio_button {
+public:
+	static_assert(Gpio >= GPIO_NUM_0 && Gpio < GPIO_NUM_MAX, "Invalid GPIO number");
+	static_assert(Edge == BUTTON_EDGE_FALLING || Edge == BUTTON_EDGE_RISING,
+			"Invalid edge");
+	static_assert(config_valid(Config), "Invalid button thresholds");
+
+	static constexpr gpio_num_t gpio = Gpio;
+	static constexpr button_edge_e edge = Edge;
+	static constexpr button_config_t config = Config;
+
+	gpio_button() = default;
+	gpio_button(const gpio_button &) = delete;
+	gpio_button &operator=(const gpio_button &) = delete;
+
+	/**
+	  * @brief Initialize the button, see button_init_config()
+	  *
+	  * @param task_priority   : Button task priority
+	  * @param task_stack_size : Button task stack size
+	  * @param buffers         : Pointer to button_static_t structure, NULL to
+	  *                          allocate the FreeRTOS objects from the heap
+	  */
+	esp_err_t init(UBaseType_t task_priority, uint32_t task_stack_size,
+			button_static_t *buffers = nullptr) {
+		return button_init_config(&button_, Gpio, Edge, task_priority,
+				task_stack_size, &config, buffers);
+	}
+
+	/**
+	  * @brief Deinitialize the button, see button_deinit()
+	  */
+	esp_err_t deinit() {
+		return button_deinit(&button_);
+	}
+
+	/**
+	  * @brief Add a callable, it is referenced and must outlive the button
+	  *
+	  * @tparam Click : Button press time to register callback function
+	  *
+	  * @param function : Callable object invoked without arguments
+	  */
+	template <button_click_e Click, typename F>
+	esp_err_t add(F &function) {
+		static_assert(Click >= BUTTON_CLICK_SINGLE && Click < BUTTON_CLICK_MAX,
+				"Invalid click type");
+
+		return button_add_cb(&button_, Click, &call<F>, &function);
+	}
+
+	/**
+	  * @brief Add a function or a captureless lambda known at compile time
+	  *
+	  * @tparam Click    : Button press time to register callback function
+	  * @tparam Function : Function invoked without arguments
+	  */
+	template <button_click_e Click, auto Function>
+	esp_err_t add() {
+		static_assert(Click >= BUTTON_CLICK_SINGLE && Click < BUTTON_CLICK_MAX,
+				"Invalid click type");
+
+		return button_add_cb(&button_, Click, &call_static<Function>, nullptr);
+	}
+
+	/**
+	  * @brief Remove all the callbacks of a click type
+	  *
+	  * @tparam Click : Button press time to unregister callback functions
+	  */
+	template <button_click_e Click>
+	esp_err_t remove() {
+		return button_remove_cb(&button_, Click);
+	}
+
+	/**
+	  * @brief Clicks or repeat number of the running callback, see
+	  *        button_get_click_count()
+	  */
+	uint8_t click_count() const {
+		return button_get_click_count(&button_);
+	}
+
+	/**
+	  * @brief Events merged in the running callback, see
+	  *        button_get_event_count()
+	  */
+	uint8_t event_count() const {
+		return button_get_event_count(&button_);
+	}
+
+	/**
+	  * @brief Underlying button instance for the C API
+	  */
+	button_t *native() {
+		return &button_;
+	}
+
+private:
+	template <typename F>
+	static void call(void *arg) {
+		(*static_cast<F *>(arg))();
+	}
+
+	template <auto Function>
+	static void call_static(void *) {
+		Function();
+	}
+
+	button_t button_ = {};
+};
+
+/**
+  * @brief Set of buttons initialized together, typically for the shared button
+  *        service
+  *
+  * The GPIO numbers of the buttons are a constexpr table checked at compile
+  * time for duplicates and, with the button registry, for its size.
+  *
+  * @tparam Buttons : gpio_button types
+  */
+template <typename... Buttons>
+class table {
+public:
+	static constexpr std::size_t size = sizeof...(Buttons);
+	static constexpr std::array<gpio_num_t, size> gpios = {Buttons::gpio...};
+
+	static_assert(size > 0, "Empty button table");
+#ifdef CONFIG_BUTTON_REGISTRY
+	static_assert(size <= CONFIG_BUTTON_MAX_BUTTONS,
+			"More buttons than CONFIG_BUTTON_MAX_BUTTONS");
+#endif /* CONFIG_BUTTON_REGISTRY */
+	static_assert(gpios_unique(gpios), "GPIO used by several buttons");
+
+	/**
+	  * @brief Initialize all the buttons, stop at the first error
+	  *
+	  * @param task_priority   : Button task priority, ignored by the button
+	  *                          service
+	  * @param task_stack_size : Button task stack size, ignored by the button
+	  *                          service
+	  */
+	esp_err_t init(UBaseType_t task_priority, uint32_t task_stack_size) {
+		esp_err_t ret = ESP_OK;
+
+		std::apply([&](auto &... buttons) {
+			((ret == ESP_OK ? (void)(ret = buttons.init(task_priority,
+					task_stack_size)) : (void)0), ...);
+		}, buttons_);
+
+		return ret;
+	}
+
+	/**
+	  * @brief Button at index I of the table
+	  */
+	template <std::size_t I>
+	auto &get() {
+		return std::get<I>(buttons_);
+	}
+
+private:
+	std::tuple<Buttons...> buttons_;
+};
+
+} /* namespace button */
+
+#endif /* BUTTON_HPP_ */
+
+/***************************** END OF FILE ************************************/
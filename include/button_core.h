@@ -0,0 +1,227 @@
+/**
+  ******************************************************************************
+  * @file           : button_core.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file contains all the definitions, data types and
+  *                   function prototypes of the hardware independent button
+  *                   debounce and click classifier
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BUTTON_CORE_H_
+#define BUTTON_CORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* Button time in microseconds */
+typedef int64_t button_time_t;
+
+/**/
+typedef enum {
+	BUTTON_CLICK_SINGLE = 0,
+	BUTTON_CLICK_MEDIUM,
+	BUTTON_CLICK_LONG,
+	BUTTON_CLICK_DOUBLE,
+	BUTTON_CLICK_TRIPLE,
+	BUTTON_CLICK_MULTI,												/*!< Four or more clicks */
+	BUTTON_CLICK_REPEAT,											/*!< Press and hold repeat */
+	BUTTON_CLICK_MAX
+} button_click_e;
+
+/* Classifier result, a button_click_e value or one of BUTTON_CORE_* */
+typedef uint8_t button_core_event_t;
+
+/* Classifier time stamp, low 32 bits of a button_time_t */
+typedef uint32_t button_core_time_t;
+
+/* Classifier thresholds, times in microseconds up to BUTTON_CORE_TIME_MAX */
+typedef struct {
+	button_core_time_t short_time;						/*!< Shorter presses are bounces */
+	button_core_time_t medium_time;						/*!< Minimum medium press time */
+	button_core_time_t long_time;							/*!< Minimum long press time */
+	button_core_time_t click_time;						/*!< Window for the next click of a multiple click */
+	button_core_time_t repeat_delay;					/*!< Hold time of the first repeat, 0 disables the repeat */
+	button_core_time_t repeat_period;					/*!< Time between repeats */
+	uint8_t max_clicks;												/*!< Clicks reported without waiting for the window, at least 2 */
+	uint8_t debounce_samples;									/*!< Equal samples to accept a level change, up to BUTTON_CORE_MAX_SAMPLES */
+} button_core_config_t;
+
+/* Classifier state of one button, packed to be kept in arrays. The times wrap
+ * around every 71 minutes, the press times are measured modulo 2^32 us */
+typedef struct {
+	button_core_time_t press_time;						/*!< Last press time, last repeat time once the press repeats */
+	button_core_time_t release_time;					/*!< Last click release time */
+	uint8_t click_counter;										/*!< Clicks in the click window */
+	uint8_t clicks;														/*!< Clicks of the last multiple click reported */
+	uint8_t repeats;													/*!< Repeats of the current press */
+	uint8_t pressed : 1;											/*!< Debounced button state */
+	uint8_t debounce_counter : 7;							/*!< Samples with the state changed */
+} button_core_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* Maximum threshold in microseconds, the time windows are compared signed */
+#define BUTTON_CORE_TIME_MAX		((button_core_time_t)INT32_MAX)
+
+/* Maximum debounce samples */
+#define BUTTON_CORE_MAX_SAMPLES	127
+
+/* No event */
+#define BUTTON_CORE_NONE		((button_core_event_t)BUTTON_CLICK_MAX)
+
+/* A press or a level change rejected as a bounce */
+#define BUTTON_CORE_BOUNCE	((button_core_event_t)(BUTTON_CLICK_MAX + 1))
+
+/* A click was counted, the click window starts */
+#define BUTTON_CORE_CLICK		((button_core_event_t)(BUTTON_CLICK_MAX + 2))
+
+/* Exported macro ------------------------------------------------------------*/
+/* True if the classifier result is a button_click_e value */
+#define BUTTON_CORE_IS_CLICK(event)	((event) < BUTTON_CLICK_MAX)
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Initialize the classifier state of a button, released and idle
+  *
+  * @param me : Pointer to button_core_t structure
+  */
+void button_core_init(button_core_t *const me);
+
+/**
+  * @brief Handle a raw edge of an interrupt driven input
+  *
+  * The edge is a press when the button is released and a release otherwise.
+  * The caller ignores the next edges until button_core_settle() is called at
+  * the end of the debounce time.
+  *
+  * @param me     : Pointer to button_core_t structure
+  * @param config : Pointer to button_core_config_t structure
+  * @param now    : Edge time
+  *
+  * @retval A click type, BUTTON_CORE_CLICK, BUTTON_CORE_BOUNCE or
+  *         BUTTON_CORE_NONE
+  */
+button_core_event_t button_core_edge(button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now);
+
+/**
+  * @brief Set the debounced state read at the end of the debounce time
+  *
+  * @param me      : Pointer to button_core_t structure
+  * @param config  : Pointer to button_core_config_t structure
+  * @param pressed : True if the input is at the pressed level
+  */
+void button_core_settle(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed);
+
+/**
+  * @brief Handle a sample of a polled input
+  *
+  * A state change is accepted after config->debounce_samples equal samples.
+  *
+  * @param me      : Pointer to button_core_t structure
+  * @param config  : Pointer to button_core_config_t structure
+  * @param pressed : True if the input is at the pressed level
+  * @param now     : Sample time
+  *
+  * @retval The result of button_core_update() for an accepted change,
+  *         BUTTON_CORE_BOUNCE for a rejected change or BUTTON_CORE_NONE
+  */
+button_core_event_t button_core_sample(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed, button_time_t now);
+
+/**
+  * @brief Handle a debounced state change
+  *
+  * @param me      : Pointer to button_core_t structure
+  * @param config  : Pointer to button_core_config_t structure
+  * @param pressed : New debounced state
+  * @param now     : State change time
+  *
+  * @retval A click type, BUTTON_CORE_CLICK or BUTTON_CORE_NONE
+  */
+button_core_event_t button_core_update(button_core_t *const me,
+		const button_core_config_t *const config, bool pressed, button_time_t now);
+
+/**
+  * @brief Report the timed gestures, the multiple clicks when the click window
+  *        expires and the repeats of a held press
+  *
+  * It can run concurrently with button_core_edge(), the click counter is
+  * updated atomically. A call reports one event, the caller calls it again
+  * until it returns BUTTON_CORE_NONE.
+  *
+  * @param me     : Pointer to button_core_t structure
+  * @param config : Pointer to button_core_config_t structure
+  * @param now    : Current time
+  *
+  * @retval A click type or BUTTON_CORE_NONE
+  */
+button_core_event_t button_core_tick(button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now);
+
+/**
+  * @brief Get the time left to the next timed gesture
+  *
+  * @param me     : Pointer to button_core_t structure
+  * @param config : Pointer to button_core_config_t structure
+  * @param now    : Current time
+  *
+  * @retval Time until button_core_tick() has to be called, 0 if it is due, or
+  *         -1 if none
+  */
+button_time_t button_core_deadline(const button_core_t *const me,
+		const button_core_config_t *const config, button_time_t now);
+
+/**
+  * @brief Get the count of a reported event
+  *
+  * @param me    : Pointer to button_core_t structure
+  * @param event : Click type returned by the classifier
+  *
+  * @retval Clicks of a multiple click, repeat number of BUTTON_CLICK_REPEAT or
+  *         1 for the other click types
+  */
+uint8_t button_core_count(const button_core_t *const me,
+		button_core_event_t event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_CORE_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,169 @@
+/**
+  ******************************************************************************
+  * @file           : button_matrix.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file contains all the definitions, data types and
+  *                   function prototypes of the matrix keypad backend
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BUTTON_MATRIX_H_
+#define BUTTON_MATRIX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#include "esp_timer.h"
+
+#include "button.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Matrix keypad, the rows are driven low one at a time and the columns are
+ * read with pull-ups */
+typedef struct {
+	const gpio_num_t *rows;										/*!< Row GPIOs, open drain outputs */
+	const gpio_num_t *cols;										/*!< Column GPIOs, inputs with pull-up */
+	uint8_t rows_num;													/*!< Number of rows */
+	uint8_t cols_num;													/*!< Number of columns */
+	button_core_t *keys;											/*!< Classifier state per key, rows_num * cols_num */
+	button_core_config_t config;							/*!< Classifier thresholds shared by all the keys */
+	button_callbacks_t callbacks;							/*!< Callbacks per click type */
+	uint8_t click_mask;												/*!< Click types with a callback, bit per button_click_e */
+	uint8_t key;															/*!< Key of the running callback */
+	uint8_t click_count;											/*!< Clicks or repeat number of the running callback */
+	bool idle;																/*!< All the keys idle, scanned at the idle period */
+	uint32_t dropped;													/*!< Events dropped with the event queue full */
+	QueueHandle_t queue;											/*!< Key event queue */
+	TaskHandle_t task;												/*!< Callback task */
+	esp_timer_handle_t timer;									/*!< Scan timer */
+} button_matrix_t;
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported macro ------------------------------------------------------------*/
+/* Key index of a row and a column */
+#define BUTTON_MATRIX_KEY(me, row, col)	((row) * (me)->cols_num + (col))
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Initialize a matrix keypad
+  *
+  * One esp_timer scans the whole keypad and a single task executes the
+  * callbacks of all the keys. While every key is released and no click window
+  * is open all the rows are driven at once and the keypad is read with a
+  * single column read every CONFIG_BUTTON_MATRIX_IDLE_PERIOD.
+  *
+  * @param me              : Pointer to button_matrix_t structure
+  * @param rows            : Row GPIOs, the array must stay valid
+  * @param rows_num        : Number of rows
+  * @param cols            : Column GPIOs, the array must stay valid
+  * @param cols_num        : Number of columns
+  * @param keys            : Classifier state array of rows_num * cols_num keys
+  * @param config          : Pointer to button_config_t structure, NULL for
+  *                          BUTTON_CONFIG_DEFAULT()
+  * @param task_priority   : Callback task priority
+  * @param task_stack_size : Callback task stack size
+  *
+  * @note The debounce time is rounded to a multiple of
+  *       CONFIG_BUTTON_MATRIX_SCAN_PERIOD. A press starting while the keypad
+  *       is idle is timestamped up to CONFIG_BUTTON_MATRIX_IDLE_PERIOD late.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if is out of memory
+  */
+esp_err_t button_matrix_init(button_matrix_t *const me, const gpio_num_t *rows,
+		uint8_t rows_num, const gpio_num_t *cols, uint8_t cols_num,
+		button_core_t *keys, const button_config_t *const config,
+		UBaseType_t task_priority, uint32_t task_stack_size);
+
+/**
+  * @brief Add a callback function executed for the click type of any key
+  *
+  * @param me         : Pointer to button_matrix_t structure
+  * @param click_type : Button press time to register callback function
+  * @param function   : Callback function code
+  * @param arg        : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if the callback table of the click type is full
+  */
+esp_err_t button_matrix_add_cb(button_matrix_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg);
+
+/**
+  * @brief Remove all the callback functions of a click type
+  *
+  * @param me         : Pointer to button_matrix_t structure
+  * @param click_type : Button press time to unregister callback functions
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_matrix_remove_cb(button_matrix_t *const me,
+		button_click_e click_type);
+
+/**
+  * @brief Get the key of the running callback
+  *
+  * @param me : Pointer to button_matrix_t structure
+  *
+  * @retval Key index, row * cols_num + column
+  */
+uint8_t button_matrix_get_key(const button_matrix_t *const me);
+
+/**
+  * @brief Get the clicks of the multiple click or the repeat number handled by
+  *        the running callback
+  *
+  * @param me : Pointer to button_matrix_t structure
+  *
+  * @retval Clicks of a multiple click, repeat number of BUTTON_CLICK_REPEAT, 1
+  *         for the other click types
+  */
+uint8_t button_matrix_get_click_count(const button_matrix_t *const me);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_MATRIX_H_ */
+
+/***************************** END OF FILE ************************************/
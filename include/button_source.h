@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file           : button_source.h
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : This file contains all the definitions, data types and
+  *                   function prototypes of the polled input source backend
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BUTTON_SOURCE_H_
+#define BUTTON_SOURCE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "button.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Read the levels of all the inputs of a source at once, bit n is input n */
+typedef esp_err_t (*button_source_read_t)(void *ctx, uint32_t *levels);
+
+/* Input source description */
+typedef struct {
+	button_source_read_t read;								/*!< Batch read function, called from the source task */
+	void *ctx;																/*!< Argument of the read function, e.g. the expander handle */
+	uint8_t inputs_num;												/*!< Number of inputs, up to 32 */
+	uint32_t active_low;											/*!< Inputs pressed at low level, bit per input */
+	gpio_num_t int_gpio;											/*!< Active low change interrupt line, GPIO_NUM_NC to poll */
+} button_source_config_t;
+
+/* Polled input source, e.g. the buttons of an I2C or SPI I/O expander */
+typedef struct {
+	button_source_config_t source;						/*!< Input source description */
+	button_core_t *keys;											/*!< Classifier state per input, inputs_num */
+	button_core_config_t config;							/*!< Classifier thresholds shared by all the inputs */
+	button_callbacks_t callbacks;							/*!< Callbacks per click type */
+	uint8_t click_mask;												/*!< Click types with a callback, bit per button_click_e */
+	uint8_t key;															/*!< Input of the running callback */
+	uint8_t click_count;											/*!< Clicks or repeat number of the running callback */
+	uint32_t errors;													/*!< Failed batch reads */
+	TaskHandle_t task;												/*!< Read and callback task */
+} button_source_t;
+
+/* Exported constants --------------------------------------------------------*/
+
+/* Exported macro ------------------------------------------------------------*/
+
+/* Exported functions prototypes ---------------------------------------------*/
+/**
+  * @brief Initialize a polled input source
+  *
+  * A single task reads the levels of all the inputs with one call to
+  * source->read per scan, runs the classifier of every input and executes the
+  * callbacks. While the inputs are idle the task waits for a falling edge of
+  * source->int_gpio, or polls every CONFIG_BUTTON_SOURCE_IDLE_PERIOD without
+  * an interrupt line.
+  *
+  * @param me              : Pointer to button_source_t structure
+  * @param source          : Pointer to button_source_config_t structure
+  * @param keys            : Classifier state array of source->inputs_num
+  *                          inputs
+  * @param config          : Pointer to button_config_t structure, NULL for
+  *                          BUTTON_CONFIG_DEFAULT()
+  * @param task_priority   : Source task priority
+  * @param task_stack_size : Source task stack size
+  *
+  * @note The debounce time is rounded to a multiple of
+  *       CONFIG_BUTTON_SOURCE_SCAN_PERIOD. The read function must run in a
+  *       task, it can block on the bus.
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if is out of memory
+  */
+esp_err_t button_source_init(button_source_t *const me,
+		const button_source_config_t *const source, button_core_t *keys,
+		const button_config_t *const config, UBaseType_t task_priority,
+		uint32_t task_stack_size);
+
+/**
+  * @brief Add a callback function executed for the click type of any input
+  *
+  * @param me         : Pointer to button_source_t structure
+  * @param click_type : Button press time to register callback function
+  * @param function   : Callback function code
+  * @param arg        : Pointer to callback function argument
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  * 	- ESP_ERR_NO_MEM if the callback table of the click type is full
+  */
+esp_err_t button_source_add_cb(button_source_t *const me,
+		button_click_e click_type, button_cb_t function, void *arg);
+
+/**
+  * @brief Remove all the callback functions of a click type
+  *
+  * @param me         : Pointer to button_source_t structure
+  * @param click_type : Button press time to unregister callback functions
+  *
+  * @retval
+  * 	- ESP_OK on success
+  * 	- ESP_ERR_INVALID_ARG if the argument is invalid
+  */
+esp_err_t button_source_remove_cb(button_source_t *const me,
+		button_click_e click_type);
+
+/**
+  * @brief Get the input of the running callback
+  *
+  * @param me : Pointer to button_source_t structure
+  *
+  * @retval Input index, bit of the levels read
+  */
+uint8_t button_source_get_key(const button_source_t *const me);
+
+/**
+  * @brief Get the clicks of the multiple click or the repeat number handled by
+  *        the running callback
+  *
+  * @param me : Pointer to button_source_t structure
+  *
+  * @retval Clicks of a multiple click, repeat number of BUTTON_CLICK_REPEAT, 1
+  *         for the other click types
+  */
+uint8_t button_source_get_click_count(const button_source_t *const me);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_SOURCE_H_ */
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,399 @@
+/**
+  ******************************************************************************
+  * @file           : button_bench.c
+  * @author         : Mauricio Barroso Benavides
+  * @date           : Oct 14, 2026
+  * @brief          : On-target benchmark of the button component, injects
+  *                   double clicks with bounces on looped back GPIOs at
+  *                   increasing rates and reports the ISR cost, the latency,
+  *                   the lost events and the CPU load
+  ******************************************************************************
+  * @attention
+  *
+  * MIT License
+  *
+  * Copyright (c) 2022 Mauricio Barroso Benavides
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to
+  * deal in the Software without restriction, including without limitation the
+  * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+  * sell copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  *
+  * The above copyright notice and this permission notice shall be included in
+  * all copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+  * IN THE SOFTWARE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+#include "button.h"
+
+/* External variables --------------------------------------------------------*/
+
+/* Private typedef -----------------------------------------------------------*/
+/* Counters of one rate step */
+typedef struct {
+	uint64_t isr_cycles;											/*!< Cycles of the edge writes above the baseline */
+	uint32_t isr_cycles_max;									/*!< Slowest edge write above the baseline */
+	uint32_t isr_edges;												/*!< Measured edge writes */
+	uint32_t expected;												/*!< Double clicks injected */
+	uint32_t received;												/*!< Double click callbacks */
+	uint32_t misclassified;										/*!< Callbacks of other click types */
+} bench_step_t;
+
+/* Run time of the tasks at the start of a step */
+typedef struct {
+	TaskStatus_t tasks[32];
+	UBaseType_t num;
+	configRUN_TIME_COUNTER_TYPE total;
+} bench_runtime_t;
+
+/* Private define ------------------------------------------------------------*/
+/* Each burst is a double click, press and release edges 4 ms apart */
+#define BENCH_EDGE_GAP		4
+#define BENCH_BURST_EDGES	4
+
+/* Bounces of every edge, 20 us apart */
+#define BENCH_BOUNCES			3
+#define BENCH_BOUNCE_US		20
+
+/* Latency samples kept per step */
+#define BENCH_SAMPLES_MAX	2048
+
+/* Private macro -------------------------------------------------------------*/
+#define BENCH_ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+
+/* Private variables ---------------------------------------------------------*/
+/* Free pins of the usual development boards, looped back inside the chip */
+#if CONFIG_IDF_TARGET_ESP32
+static const gpio_num_t bench_gpios[] = {4, 5, 13, 14, 18, 19, 21, 22};
+#elif CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
+static const gpio_num_t bench_gpios[] = {4, 5, 6, 7, 15, 16, 17, 18};
+#else
+static const gpio_num_t bench_gpios[] = {0, 1, 2, 3, 4, 5, 6, 7};
+#endif /* CONFIG_IDF_TARGET_ESP32 */
+
+_Static_assert(CONFIG_BENCH_BUTTONS <= BENCH_ARRAY_SIZE(bench_gpios),
+		"Not enough benchmark GPIOs");
+
+/* Double clicks per second and button of each step */
+static const uint32_t bench_rates[] = {2, 5, 10, 20, 40};
+
+/* Double clicks reported at once, no multiple click window to wait for */
+static const button_config_t bench_config = {
+		.debounce_time = 2,
+		.click_time = 50,
+		.medium_time = 500,
+		.long_time = 1000,
+		.repeat_delay = 0,
+		.repeat_period = 0,
+		.max_clicks = 2
+};
+
+static button_t buttons[CONFIG_BENCH_BUTTONS];
+
+/* Time of the last injected release of each button */
+static volatile int64_t release_time[CONFIG_BENCH_BUTTONS];
+
+/* Cycles of an edge write without interrupt */
+static uint32_t baseline_cycles;
+
+static bench_step_t step;
+static uint32_t samples[BENCH_SAMPLES_MAX];
+static uint32_t samples_num;
+
+static bench_runtime_t runtime;
+
+/* Private function prototypes -----------------------------------------------*/
+static void bench_double_cb(void *arg);
+static void bench_other_cb(void *arg);
+static uint32_t bench_write(gpio_num_t gpio, uint32_t level);
+static void bench_edge(bool pressed, bool last);
+static void bench_step(uint32_t rate);
+static void bench_runtime_take(bench_runtime_t *const snapshot);
+static uint32_t bench_task_load(const bench_runtime_t *const start);
+static int bench_compare(const void *a, const void *b);
+static const char *bench_mode(void);
+
+/* Exported functions --------------------------------------------------------*/
+void app_main(void) {
+	/* The edges are written above the button tasks, the GPIO ISR runs on this
+	 * core */
+	vTaskPrioritySet(NULL, configMAX_PRIORITIES - 5);
+
+	/* Cost of an edge write on pins without interrupt */
+	uint64_t cycles = 0;
+
+	for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+		gpio_reset_pin(bench_gpios[i]);
+		gpio_set_level(bench_gpios[i], 1);
+		gpio_set_direction(bench_gpios[i], GPIO_MODE_INPUT_OUTPUT);
+	}
+
+	for (uint32_t i = 0; i < 256; i++) {
+		cycles += bench_write(bench_gpios[i % CONFIG_BENCH_BUTTONS], i & 1);
+	}
+
+	baseline_cycles = (uint32_t)(cycles / 256);
+
+	/* Button to ground, the pin output drives the input */
+	for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+		gpio_set_level(bench_gpios[i], 1);
+
+		ESP_ERROR_CHECK(button_init_config(&buttons[i], bench_gpios[i],
+				BUTTON_EDGE_FALLING, tskIDLE_PRIORITY + 10,
+				configMINIMAL_STACK_SIZE * 4, &bench_config, NULL));
+
+		gpio_set_level(bench_gpios[i], 1);
+		gpio_set_direction(bench_gpios[i], GPIO_MODE_INPUT_OUTPUT);
+
+		button_add_cb(&buttons[i], BUTTON_CLICK_DOUBLE, bench_double_cb,
+				(void *)(uintptr_t)i);
+		button_add_cb(&buttons[i], BUTTON_CLICK_SINGLE, bench_other_cb, NULL);
+		button_add_cb(&buttons[i], BUTTON_CLICK_MEDIUM, bench_other_cb, NULL);
+	}
+
+	printf("Button benchmark: %s, %d buttons, %d ms per step, edge write "
+			"%lu cycles\n", bench_mode(), CONFIG_BENCH_BUTTONS,
+			CONFIG_BENCH_STEP_TIME, (unsigned long)baseline_cycles);
+
+	uint32_t lost = 0;
+
+	for (uint8_t i = 0; i < BENCH_ARRAY_SIZE(bench_rates); i++) {
+		bench_step(bench_rates[i]);
+
+		if (i == 0) {
+			lost = step.expected - step.received;
+		}
+	}
+
+	printf("Benchmark done: %lu events lost at the lowest rate\n",
+			(unsigned long)lost);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void bench_double_cb(void *arg) {
+	uint32_t id = (uint32_t)(uintptr_t)arg;
+	uint32_t latency = (uint32_t)(esp_timer_get_time() - release_time[id]);
+	uint32_t sample = __atomic_fetch_add(&samples_num, 1, __ATOMIC_RELAXED);
+
+	if (sample < BENCH_SAMPLES_MAX) {
+		samples[sample] = latency;
+	}
+
+	__atomic_fetch_add(&step.received, 1, __ATOMIC_RELAXED);
+}
+
+static void bench_other_cb(void *arg) {
+	__atomic_fetch_add(&step.misclassified, 1, __ATOMIC_RELAXED);
+}
+
+static uint32_t bench_write(gpio_num_t gpio, uint32_t level) {
+	/* The input read waits for the write, the interrupt is taken before it
+	 * returns */
+	uint32_t start = esp_cpu_get_cycle_count();
+
+	gpio_set_level(gpio, level);
+	(void)gpio_get_level(gpio);
+
+	return esp_cpu_get_cycle_count() - start;
+}
+
+static void bench_edge(bool pressed, bool last) {
+	uint32_t level = pressed ? 0 : 1;
+
+	/* The first write of every pin raises its interrupt */
+	for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+		if (last) {
+			release_time[i] = esp_timer_get_time();
+		}
+
+		uint32_t cycles = bench_write(bench_gpios[i], level);
+
+		cycles = cycles > baseline_cycles ? cycles - baseline_cycles : 0;
+		step.isr_cycles += cycles;
+		step.isr_edges++;
+
+		if (cycles > step.isr_cycles_max) {
+			step.isr_cycles_max = cycles;
+		}
+	}
+
+	/* Contact bounces, filtered by the debounce */
+	for (uint8_t bounce = 0; bounce < BENCH_BOUNCES; bounce++) {
+		esp_rom_delay_us(BENCH_BOUNCE_US);
+
+		for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+			gpio_set_level(bench_gpios[i], !level);
+		}
+
+		esp_rom_delay_us(BENCH_BOUNCE_US);
+
+		for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+			gpio_set_level(bench_gpios[i], level);
+		}
+	}
+}
+
+static void bench_step(uint32_t rate) {
+	uint32_t bursts = CONFIG_BENCH_STEP_TIME * rate / 1000;
+	TickType_t period = pdMS_TO_TICKS(1000 / rate);
+	button_stats_t stats_start[CONFIG_BENCH_BUTTONS];
+
+	memset(&step, 0, sizeof(step));
+	samples_num = 0;
+
+	for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+		button_get_stats(&buttons[i], &stats_start[i]);
+	}
+
+	bench_runtime_take(&runtime);
+
+	int64_t start = esp_timer_get_time();
+	TickType_t wake = xTaskGetTickCount();
+
+	for (uint32_t burst = 0; burst < bursts; burst++) {
+		for (uint8_t edge = 0; edge < BENCH_BURST_EDGES; edge++) {
+			bench_edge(edge % 2 == 0, edge == BENCH_BURST_EDGES - 1);
+
+			if (edge < BENCH_BURST_EDGES - 1) {
+				vTaskDelayUntil(&wake, pdMS_TO_TICKS(BENCH_EDGE_GAP));
+			}
+		}
+
+		step.expected += CONFIG_BENCH_BUTTONS;
+		vTaskDelayUntil(&wake, period -
+				pdMS_TO_TICKS(BENCH_EDGE_GAP * (BENCH_BURST_EDGES - 1)));
+	}
+
+	/* Let the last events be dispatched */
+	vTaskDelay(pdMS_TO_TICKS(bench_config.click_time * 2));
+
+	int64_t elapsed = esp_timer_get_time() - start;
+	uint32_t load = bench_task_load(&runtime);
+
+	/* Dropped and merged events of all the buttons */
+	uint32_t dropped = 0;
+	uint32_t coalesced = 0;
+	uint32_t bounces = 0;
+
+	for (uint8_t i = 0; i < CONFIG_BENCH_BUTTONS; i++) {
+		button_stats_t stats;
+
+		button_get_stats(&buttons[i], &stats);
+		dropped += stats.dropped - stats_start[i].dropped;
+		coalesced += stats.coalesced - stats_start[i].coalesced;
+		bounces += stats.bounces - stats_start[i].bounces;
+	}
+
+	/* Latency percentiles */
+	uint32_t num = samples_num < BENCH_SAMPLES_MAX ? samples_num :
+			BENCH_SAMPLES_MAX;
+	uint32_t p50 = 0, p90 = 0, p99 = 0, max = 0;
+
+	if (num > 0) {
+		qsort(samples, num, sizeof(samples[0]), bench_compare);
+		p50 = samples[num * 50 / 100];
+		p90 = samples[num * 90 / 100];
+		p99 = samples[num * 99 / 100];
+		max = samples[num - 1];
+	}
+
+	/* ISR load in hundredths of a percent of one core */
+	uint32_t isr_load = (uint32_t)(step.isr_cycles * 10000 /
+			((uint64_t)esp_rom_get_cpu_ticks_per_us() * (uint64_t)elapsed));
+
+	printf("rate %2lu/s: isr %lu avg %lu max cycles, latency p50 %lu p90 %lu "
+			"p99 %lu max %lu us, events %lu/%lu, misclassified %lu, dropped %lu, "
+			"coalesced %lu, bounces %lu, task load %lu.%02lu%%, isr load "
+			"%lu.%02lu%%\n",
+			(unsigned long)rate,
+			(unsigned long)(step.isr_edges ? step.isr_cycles / step.isr_edges : 0),
+			(unsigned long)step.isr_cycles_max,
+			(unsigned long)p50, (unsigned long)p90, (unsigned long)p99,
+			(unsigned long)max,
+			(unsigned long)step.received, (unsigned long)step.expected,
+			(unsigned long)step.misclassified, (unsigned long)dropped,
+			(unsigned long)coalesced, (unsigned long)bounces,
+			(unsigned long)(load / 100), (unsigned long)(load % 100),
+			(unsigned long)(isr_load / 100), (unsigned long)(isr_load % 100));
+}
+
+static void bench_runtime_take(bench_runtime_t *const snapshot) {
+	snapshot->num = uxTaskGetSystemState(snapshot->tasks,
+			BENCH_ARRAY_SIZE(snapshot->tasks), &snapshot->total);
+}
+
+static uint32_t bench_task_load(const bench_runtime_t *const start) {
+	static bench_runtime_t end;
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	uint64_t busy = 0;
+
+	bench_runtime_take(&end);
+
+	/* Every task but the idle tasks and the injection, which also takes the
+	 * GPIO interrupts */
+	for (UBaseType_t i = 0; i < end.num; i++) {
+		const TaskStatus_t *task = &end.tasks[i];
+
+		if (task->xHandle == self || strncmp(task->pcTaskName, "IDLE", 4) == 0) {
+			continue;
+		}
+
+		configRUN_TIME_COUNTER_TYPE before = 0;
+
+		for (UBaseType_t j = 0; j < start->num; j++) {
+			if (start->tasks[j].xHandle == task->xHandle) {
+				before = start->tasks[j].ulRunTimeCounter;
+				break;
+			}
+		}
+
+		busy += task->ulRunTimeCounter - before;
+	}
+
+	configRUN_TIME_COUNTER_TYPE total = end.total - start->total;
+
+	/* Hundredths of a percent of one core */
+	return total > 0 ? (uint32_t)(busy * 10000 / total) : 0;
+}
+
+static int bench_compare(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static const char *bench_mode(void) {
+#if defined(CONFIG_BUTTON_TASK_MODE_PER_BUTTON)
+	return "per button task, timers engine";
+#elif defined(CONFIG_BUTTON_ENGINE_TIMERS)
+	return "shared service, timers engine";
+#else
+	return "shared service, scan engine";
+#endif /* CONFIG_BUTTON_TASK_MODE_PER_BUTTON */
+}
+
+/***************************** END OF FILE ************************************/
@@ -0,0 +1,11 @@
+# SPDX-License-Identifier: MIT
+import pytest
+from pytest_embedded import Dut
+
+
+@pytest.mark.generic
+@pytest.mark.parametrize('config', ['per_button', 'service', 'scan'], indirect=True)
+def test_button_bench(dut: Dut) -> None:
+    # Each step reports one line, no event may be lost at the lowest rate
+    match = dut.expect(r'Benchmark done: (\d+) events lost at the lowest rate', timeout=120)
+    assert int(match.group(1)) == 0